@@ -0,0 +1,399 @@
+#include "bletransport.h"
+
+// system includes
+#include <algorithm>
+
+// local includes
+#include "tracing.h"
+
+BleTransport::BleTransport(QObject *parent) :
+    BobbycarTransport{parent},
+    m_reconnectTimer{this}
+{
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &BleTransport::reconnect);
+}
+
+BleTransport::~BleTransport()
+{
+    deleteService();
+
+    if (m_control)
+        m_control->disconnectFromDevice();
+}
+
+void BleTransport::connectToDevice(const QBluetoothDeviceInfo &device)
+{
+    m_currentDevice = device;
+    m_connectionWanted = true;
+    m_reconnectAttempt = 0;
+    m_reconnectTimer.stop();
+
+    connectController();
+}
+
+void BleTransport::connectController()
+{
+    m_foundBobbycarService = false;
+
+    // Disconnect and delete old connection
+    deleteService();
+    m_notificationDescriptors.clear();
+    m_descriptorCharacteristics.clear();
+
+    if (m_control)
+    {
+        // replacing the controller is no reason to reconnect
+        m_control->disconnect(this);
+        m_control->disconnectFromDevice();
+        delete m_control;
+        m_control = nullptr;
+    }
+
+    setState(State::Disconnected);
+    setMtu(defaultAttMtu);
+
+    // Create new controller and connect it if device available
+    if (m_currentDevice.isValid())
+    {
+        // Make connections
+        m_control = QLowEnergyController::createCentral(m_currentDevice, this);
+        m_control->setRemoteAddressType(m_addressType);
+
+        connect(m_control, &QLowEnergyController::mtuChanged, this, &BleTransport::setMtu);
+        connect(m_control, &QLowEnergyController::connectionUpdated, this, &BleTransport::connectionParametersChanged);
+        connect(m_control, &QLowEnergyController::serviceDiscovered,
+                this, &BleTransport::serviceDiscovered);
+        connect(m_control, &QLowEnergyController::discoveryFinished,
+                this, &BleTransport::serviceScanDone);
+
+        connect(m_control, static_cast<void (QLowEnergyController::*)(QLowEnergyController::Error)>(&QLowEnergyController::error),
+                this, [this](QLowEnergyController::Error error) {
+            Q_UNUSED(error);
+            emit errorOccurred("Cannot connect to remote device.");
+            connectionLost();
+        });
+        connect(m_control, &QLowEnergyController::connected, this, [this]() {
+            emit infoMessage("Controller connected. Search services...");
+            setState(State::Discovering);
+            m_control->discoverServices();
+        });
+        connect(m_control, &QLowEnergyController::disconnected, this, [this]() {
+            emit errorOccurred("LowEnergy controller disconnected");
+            m_pendingWrites.clear();
+            m_pendingDescriptorWrites.clear();
+            setState(State::Disconnected);
+            connectionLost();
+        });
+
+        // Connect
+        setState(State::Connecting);
+        m_control->connectToDevice();
+    }
+}
+
+void BleTransport::connectionLost()
+{
+    if (!m_connectionWanted || m_reconnectTimer.isActive())
+        return;
+
+    const int delay = std::min(maxReconnectDelay, minReconnectDelay << std::min(m_reconnectAttempt, 16));
+    m_reconnectAttempt++;
+
+    emit infoMessage(tr("Connection lost, reconnecting in %0 s...").arg(delay / 1000., 0, 'f', 1));
+    setState(State::Disconnected);
+    m_reconnectTimer.start(delay);
+}
+
+void BleTransport::reconnect()
+{
+    if (!m_connectionWanted)
+        return;
+
+    connectController();
+}
+
+void BleTransport::disconnectFromDevice()
+{
+    m_foundBobbycarService = false;
+    m_connectionWanted = false;
+    m_reconnectTimer.stop();
+
+    if (!m_service && m_control)
+    {
+        // still connecting or discovering, nothing to switch off first
+        m_control->disconnectFromDevice();
+        setState(State::Disconnected);
+        return;
+    }
+
+    //disable notifications
+    if (m_service)
+    {
+        setState(State::Disconnecting);
+
+        for (const auto &descriptor : qAsConst(m_notificationDescriptors))
+            if (descriptor.isValid() && descriptor.value() == QByteArray::fromHex("0100"))
+                m_service->writeDescriptor(descriptor, QByteArray::fromHex("0000"));
+
+        m_notificationDescriptors.erase(std::remove_if(std::begin(m_notificationDescriptors), std::end(m_notificationDescriptors),
+                                                       [](const QLowEnergyDescriptor &descriptor){
+            return !descriptor.isValid() || descriptor.value() != QByteArray::fromHex("0100");
+        }), std::end(m_notificationDescriptors));
+
+        disconnectInternal();
+    }
+}
+
+void BleTransport::disconnectInternal()
+{
+    if (m_notificationDescriptors.isEmpty())
+    {
+        //disabled notifications -> assume disconnect intent
+        if (m_control)
+            m_control->disconnectFromDevice();
+
+        deleteService();
+    }
+}
+
+void BleTransport::deleteService()
+{
+    if (m_service)
+    {
+        delete m_service;
+        m_service = nullptr;
+    }
+}
+
+bool BleTransport::hasCharacteristic(const QBluetoothUuid &uuid) const
+{
+    return m_service && m_service->characteristic(uuid).isValid();
+}
+
+bool BleTransport::supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const
+{
+    if (!m_service)
+        return false;
+
+    const QLowEnergyCharacteristic characteristic = m_service->characteristic(uuid);
+    return characteristic.isValid() && (characteristic.properties() & QLowEnergyCharacteristic::WriteNoResponse);
+}
+
+void BleTransport::setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled)
+{
+    if (!m_service)
+    {
+        failDescriptorWrite(uuid);
+        return;
+    }
+
+    const QLowEnergyCharacteristic characteristic = m_service->characteristic(uuid);
+    if (!characteristic.isValid())
+    {
+        qWarning() << "unknown characteristic" << uuid;
+        failDescriptorWrite(uuid);
+        return;
+    }
+
+    const QLowEnergyDescriptor descriptor = characteristic.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
+    if (!descriptor.isValid())
+    {
+        qWarning() << "characteristic without notifications" << uuid;
+        failDescriptorWrite(uuid);
+        return;
+    }
+
+    if (enabled && !m_notificationDescriptors.contains(descriptor))
+        m_notificationDescriptors.push_back(descriptor);
+    m_descriptorCharacteristics.insert(descriptor.handle(), uuid);
+
+    m_pendingDescriptorWrites.push_back(uuid);
+    m_service->writeDescriptor(descriptor, enabled ? QByteArray::fromHex("0100") : QByteArray::fromHex("0000"));
+}
+
+void BleTransport::writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse)
+{
+    if (!m_service)
+    {
+        if (withResponse)
+            failWrite(uuid);
+        return;
+    }
+
+    const QLowEnergyCharacteristic characteristic = m_service->characteristic(uuid);
+    if (!characteristic.isValid())
+    {
+        qWarning() << "unknown characteristic" << uuid;
+        if (withResponse)
+            failWrite(uuid);
+        return;
+    }
+
+    if (withResponse)
+    {
+        m_pendingWrites.push_back(uuid);
+        m_service->writeCharacteristic(characteristic, value);
+    }
+    else
+        m_service->writeCharacteristic(characteristic, value, QLowEnergyService::WriteWithoutResponse);
+}
+
+bool BleTransport::requestConnectionParameters(const QLowEnergyConnectionParameters &parameters)
+{
+    if (!m_control)
+        return false;
+
+    // the service is set up before the rest of the service scan is done, so
+    // the link is already usable while the controller is still discovering
+    switch (m_control->state())
+    {
+    case QLowEnergyController::ConnectedState:
+    case QLowEnergyController::DiscoveringState:
+    case QLowEnergyController::DiscoveredState:
+        m_control->requestConnectionUpdate(parameters);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void BleTransport::serviceDiscovered(const QBluetoothUuid &gatt)
+{
+    if (gatt == bobbycarServiceUuid)
+    {
+        m_foundBobbycarService = true;
+
+        // no need to wait for the remaining services
+        emit infoMessage("Bobbycar service discovered.");
+        createService();
+    }
+}
+
+void BleTransport::serviceScanDone()
+{
+    emit infoMessage("Service scan done.");
+
+    // already set up when it was discovered
+    if (m_service)
+        return;
+
+    // If bobbycarService found, create new service
+    if (m_foundBobbycarService)
+        createService();
+
+    if (!m_service)
+        emit errorOccurred("Bobbycar Service not found.");
+}
+
+void BleTransport::createService()
+{
+    // Delete old service if available
+    deleteService();
+
+    m_service = m_control->createServiceObject(bobbycarServiceUuid, this);
+
+    if (m_service)
+    {
+        connect(m_service, &QLowEnergyService::stateChanged, this, &BleTransport::serviceStateChanged);
+        connect(m_service, &QLowEnergyService::characteristicChanged, this, &BleTransport::updateCharacteristic);
+        connect(m_service, &QLowEnergyService::descriptorWritten, this, &BleTransport::confirmedDescriptorWrite);
+        connect(m_service, &QLowEnergyService::characteristicWritten, this, &BleTransport::confirmedCharacteristicWrite);
+        connect(m_service, qOverload<QLowEnergyService::ServiceError>(&QLowEnergyService::error),
+                this, &BleTransport::serviceError);
+        m_service->discoverDetails();
+    }
+}
+
+void BleTransport::serviceStateChanged(QLowEnergyService::ServiceState s)
+{
+    BOBBYCAR_TRACE(lcBle, TraceEvent::ServiceState, int(s), 0);
+
+    m_pendingWrites.clear();
+    m_pendingDescriptorWrites.clear();
+
+    switch (s)
+    {
+    case QLowEnergyService::DiscoveringServices:
+        emit infoMessage(tr("Discovering services..."));
+        setState(State::Discovering);
+        break;
+    case QLowEnergyService::ServiceDiscovered:
+        m_reconnectAttempt = 0;
+        setMtu(m_control->mtu());
+        emit infoMessage(tr("Service discovered."));
+        setState(State::Ready);
+        break;
+    default:
+        setState(State::Disconnected);
+        break;
+    }
+}
+
+void BleTransport::updateCharacteristic(const QLowEnergyCharacteristic &c, const QByteArray &value)
+{
+    emit characteristicChanged(c.uuid(), value);
+}
+
+void BleTransport::confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value)
+{
+    BOBBYCAR_TRACE(lcBle, TraceEvent::DescriptorWritten, value == QByteArray::fromHex("0100"), d.handle());
+
+    const auto iter = m_descriptorCharacteristics.constFind(d.handle());
+    if (iter != m_descriptorCharacteristics.constEnd())
+    {
+        // the ones disconnectFromDevice() writes itself were never pending
+        const auto pending = std::find(std::begin(m_pendingDescriptorWrites), std::end(m_pendingDescriptorWrites), *iter);
+        if (pending != std::end(m_pendingDescriptorWrites))
+            m_pendingDescriptorWrites.erase(pending);
+
+        emit descriptorWritten(*iter, value == QByteArray::fromHex("0100"));
+    }
+    if (d.isValid() && value == QByteArray::fromHex("0000"))
+    {
+        m_notificationDescriptors.removeAll(d);
+
+        if (state() == State::Disconnecting)
+            disconnectInternal();
+    }
+}
+
+void BleTransport::confirmedCharacteristicWrite(const QLowEnergyCharacteristic &info, const QByteArray &value)
+{
+    if (!m_pendingWrites.empty())
+        m_pendingWrites.pop_front();
+
+    emit characteristicWritten(info.uuid(), value);
+}
+
+void BleTransport::serviceError(QLowEnergyService::ServiceError error)
+{
+    qWarning() << "serviceError" << error;
+
+    if (error == QLowEnergyService::CharacteristicWriteError && !m_pendingWrites.empty())
+    {
+        const QBluetoothUuid uuid = m_pendingWrites.front();
+        m_pendingWrites.pop_front();
+        emit writeFailed(uuid);
+    }
+    else if (error == QLowEnergyService::DescriptorWriteError && !m_pendingDescriptorWrites.empty())
+    {
+        const QBluetoothUuid uuid = m_pendingDescriptorWrites.front();
+        m_pendingDescriptorWrites.pop_front();
+        emit descriptorWritten(uuid, false);
+    }
+}
+
+void BleTransport::failWrite(const QBluetoothUuid &uuid)
+{
+    QMetaObject::invokeMethod(this, [this, uuid]() {
+        emit writeFailed(uuid);
+    }, Qt::QueuedConnection);
+}
+
+void BleTransport::failDescriptorWrite(const QBluetoothUuid &uuid)
+{
+    QMetaObject::invokeMethod(this, [this, uuid]() {
+        emit descriptorWritten(uuid, false);
+    }, Qt::QueuedConnection);
+}
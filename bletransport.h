@@ -0,0 +1,93 @@
+#pragma once
+
+// system includes
+#include <deque>
+
+// Qt includes
+#include <QTimer>
+#include <QVector>
+#include <QHash>
+#include <QLowEnergyController>
+#include <QLowEnergyService>
+
+// local includes
+#include "bobbycartransport.h"
+
+// Talks to a real bobbycar through QLowEnergyController. Sets the service up
+// as soon as it is discovered and reconnects with exponential backoff when
+// the link drops without being asked to.
+class BleTransport : public BobbycarTransport
+{
+    Q_OBJECT
+
+public:
+    static constexpr int minReconnectDelay = 500;
+    static constexpr int maxReconnectDelay = 30000;
+
+    explicit BleTransport(QObject *parent = nullptr);
+    ~BleTransport() override;
+
+    void setRemoteAddressType(QLowEnergyController::RemoteAddressType type) override { m_addressType = type; }
+
+    void connectToDevice(const QBluetoothDeviceInfo &device) override;
+    void disconnectFromDevice() override;
+
+    bool hasCharacteristic(const QBluetoothUuid &uuid) const override;
+    bool supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const override;
+
+    void setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled) override;
+
+    void writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse = true) override;
+
+    bool requestConnectionParameters(const QLowEnergyConnectionParameters &parameters) override;
+
+private:
+    void connectController();
+    void createService();
+    void connectionLost();
+    void reconnect();
+    void disconnectInternal();
+    void deleteService();
+    // queued, the scheduler never gets a confirmation synchronously
+    void failWrite(const QBluetoothUuid &uuid);
+    void failDescriptorWrite(const QBluetoothUuid &uuid);
+
+    //QLowEnergyController
+    void serviceDiscovered(const QBluetoothUuid &);
+    void serviceScanDone();
+
+    //QLowEnergyService
+    void serviceStateChanged(QLowEnergyService::ServiceState s);
+    void updateCharacteristic(const QLowEnergyCharacteristic &c,
+                              const QByteArray &value);
+    void confirmedDescriptorWrite(const QLowEnergyDescriptor &d,
+                                  const QByteArray &value);
+    void confirmedCharacteristicWrite(const QLowEnergyCharacteristic &info,
+                                      const QByteArray &value);
+    void serviceError(QLowEnergyService::ServiceError error);
+
+private:
+    QLowEnergyController::RemoteAddressType m_addressType = QLowEnergyController::PublicAddress;
+    QLowEnergyController *m_control = nullptr;
+    QLowEnergyService *m_service = nullptr;
+    QBluetoothDeviceInfo m_currentDevice;
+
+    bool m_foundBobbycarService{};
+
+    // false once disconnectFromDevice() was called, any other loss of the
+    // link is reconnected
+    bool m_connectionWanted{};
+    int m_reconnectAttempt{};
+    QTimer m_reconnectTimer;
+
+    // client characteristic configuration descriptors with notifications on
+    QVector<QLowEnergyDescriptor> m_notificationDescriptors;
+    // characteristic each written descriptor belongs to, by descriptor handle
+    QHash<QLowEnergyHandle, QBluetoothUuid> m_descriptorCharacteristics;
+
+    // characteristics of the writes with response not yet confirmed, in
+    // order, to tell which one a CharacteristicWriteError belongs to
+    std::deque<QBluetoothUuid> m_pendingWrites;
+    // the same for descriptor writes and DescriptorWriteError
+    std::deque<QBluetoothUuid> m_pendingDescriptorWrites;
+};
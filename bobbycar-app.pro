@@ -1,25 +1,10 @@
 TEMPLATE = app
 TARGET = bobbycar-app
 
-QT += qml quick bluetooth
-CONFIG += c++17
-
-HEADERS += \
-    connectionhandler.h \
-    deviceinfo.h \
-    devicefinder.h \
-    devicehandler.h \
-    bluetoothbaseclass.h \
-    settings.h
+include(bobbycar.pri)
 
 SOURCES += \
-    main.cpp \
-    connectionhandler.cpp \
-    deviceinfo.cpp \
-    devicefinder.cpp \
-    devicehandler.cpp \
-    bluetoothbaseclass.cpp \
-    settings.cpp
+    main.cpp
 
 RESOURCES += \
     qml.qrc \
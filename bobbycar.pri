@@ -0,0 +1,74 @@
+# Everything but main.cpp, shared by the app and the test projects
+
+QT += qml quick bluetooth
+CONFIG += c++17
+
+# the bobbycar.* trace categories only log in debug builds, the trace ring
+# stays available in both
+CONFIG(release, debug|release): DEFINES += QT_NO_DEBUG_OUTPUT
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+HEADERS += \
+    $$PWD/connectionhandler.h \
+    $$PWD/deviceinfo.h \
+    $$PWD/drivingmetrics.h \
+    $$PWD/devicefinder.h \
+    $$PWD/devicehandler.h \
+    $$PWD/carsettings.h \
+    $$PWD/fleetmanager.h \
+    $$PWD/gattscheduler.h \
+    $$PWD/deviceworker.h \
+    $$PWD/bluetoothbaseclass.h \
+    $$PWD/bobbycartransport.h \
+    $$PWD/bletransport.h \
+    $$PWD/simulatedtransport.h \
+    $$PWD/connectionprofile.h \
+    $$PWD/latencyhistogram.h \
+    $$PWD/livestatsreassembler.h \
+    $$PWD/livestats.h \
+    $$PWD/remotecontrolframe.h \
+    $$PWD/remotecontrolmixer.h \
+    $$PWD/settingsframe.h \
+    $$PWD/sessionrecorder.h \
+    $$PWD/sessionreplay.h \
+    $$PWD/spscqueue.h \
+    $$PWD/settings.h \
+    $$PWD/telemetrysnapshot.h \
+    $$PWD/telemetryhistory.h \
+    $$PWD/telemetrychart.h \
+    $$PWD/tracing.h \
+    $$PWD/wifilist.h \
+    $$PWD/wifilistmodel.h
+
+SOURCES += \
+    $$PWD/connectionhandler.cpp \
+    $$PWD/deviceinfo.cpp \
+    $$PWD/drivingmetrics.cpp \
+    $$PWD/devicefinder.cpp \
+    $$PWD/devicehandler.cpp \
+    $$PWD/carsettings.cpp \
+    $$PWD/fleetmanager.cpp \
+    $$PWD/gattscheduler.cpp \
+    $$PWD/deviceworker.cpp \
+    $$PWD/bluetoothbaseclass.cpp \
+    $$PWD/bobbycartransport.cpp \
+    $$PWD/bletransport.cpp \
+    $$PWD/simulatedtransport.cpp \
+    $$PWD/connectionprofile.cpp \
+    $$PWD/latencyhistogram.cpp \
+    $$PWD/livestatsreassembler.cpp \
+    $$PWD/livestats.cpp \
+    $$PWD/remotecontrolframe.cpp \
+    $$PWD/remotecontrolmixer.cpp \
+    $$PWD/settingsframe.cpp \
+    $$PWD/sessionrecorder.cpp \
+    $$PWD/sessionreplay.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/telemetrysnapshot.cpp \
+    $$PWD/telemetryhistory.cpp \
+    $$PWD/telemetrychart.cpp \
+    $$PWD/tracing.cpp \
+    $$PWD/wifilist.cpp \
+    $$PWD/wifilistmodel.cpp
@@ -0,0 +1,21 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    app
+
+app.file = bobbycar-app.pro
+
+# the test projects build the app sources for the host, not for Android
+!android {
+    SUBDIRS += \
+        benchmarks \
+        devicefinder \
+        gattscheduler
+
+    # qmake && make && make -C tests/benchmarks benchmark
+    benchmarks.subdir = tests/benchmarks
+
+    # qmake && make && make check
+    devicefinder.subdir = tests/devicefinder
+    gattscheduler.subdir = tests/gattscheduler
+}
@@ -0,0 +1,36 @@
+#include "bobbycartransport.h"
+
+// local includes
+#include "tracing.h"
+
+const QBluetoothUuid bobbycarServiceUuid{QUuid::fromString(QStringLiteral("0335e46c-f355-4ce6-8076-017de08cee98"))};
+
+const QBluetoothUuid livestatsCharacUuid{QUuid::fromString(QStringLiteral("a48321ea-329f-4eab-a401-30e247211524"))};
+const QBluetoothUuid remotecontrolCharacUuid{QUuid::fromString(QStringLiteral("4201def0-a264-43e6-946b-6b2d9612dfed"))};
+
+const QBluetoothUuid settingsSetterUuid{QUuid::fromString(QStringLiteral("4201def1-a264-43e6-946b-6b2d9612dfed"))};
+const QBluetoothUuid wifiListUuid{QUuid::fromString(QStringLiteral("4201def2-a264-43e6-946b-6b2d9612dfed"))};
+
+BobbycarTransport::BobbycarTransport(QObject *parent) :
+    QObject{parent}
+{
+}
+
+void BobbycarTransport::setMtu(int mtu)
+{
+    if (m_mtu == mtu)
+        return;
+
+    m_mtu = mtu;
+    emit mtuChanged(m_mtu);
+}
+
+void BobbycarTransport::setState(State state)
+{
+    if (m_state == state)
+        return;
+
+    BOBBYCAR_TRACE(lcBle, TraceEvent::TransportState, int(state), int(m_state));
+    m_state = state;
+    emit stateChanged();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Qt includes
+#include <QObject>
+#include <QBluetoothDeviceInfo>
+#include <QBluetoothUuid>
+#include <QLowEnergyController>
+#include <QLowEnergyConnectionParameters>
+
+extern const QBluetoothUuid bobbycarServiceUuid;
+
+extern const QBluetoothUuid livestatsCharacUuid;
+extern const QBluetoothUuid remotecontrolCharacUuid;
+
+extern const QBluetoothUuid settingsSetterUuid;
+extern const QBluetoothUuid wifiListUuid;
+
+// ATT MTU every link starts with, a notification or write request carries up
+// to MTU - 3 bytes
+constexpr int defaultAttMtu = 23;
+constexpr int attNotificationOverhead = 3;
+constexpr int attWriteOverhead = 3;
+
+// The GATT interactions DeviceHandler needs with a bobbycar, implemented by
+// BleTransport for real cars and by SimulatedTransport for tests and
+// benchmarks without Bluetooth hardware.
+class BobbycarTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Disconnected,
+        Connecting,
+        Discovering,
+        // bobbycar service and its characteristics are usable
+        Ready,
+        Disconnecting
+    };
+    Q_ENUM(State)
+
+    explicit BobbycarTransport(QObject *parent = nullptr);
+
+    State state() const { return m_state; }
+    bool isReady() const { return m_state == State::Ready; }
+
+    // negotiated ATT MTU of the current link
+    int mtu() const { return m_mtu; }
+
+    virtual bool isSimulated() const { return false; }
+
+    // only relevant for BlueZ, ignored by other transports
+    virtual void setRemoteAddressType(QLowEnergyController::RemoteAddressType type) { Q_UNUSED(type) }
+
+    virtual void connectToDevice(const QBluetoothDeviceInfo &device) = 0;
+    // disables all notifications first, then drops the connection
+    virtual void disconnectFromDevice() = 0;
+
+    virtual bool hasCharacteristic(const QBluetoothUuid &uuid) const = 0;
+    virtual bool supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const = 0;
+
+    // ends in descriptorWritten() once the car confirmed the change, with
+    // notificationsEnabled false if the descriptor could not be written
+    virtual void setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled) = 0;
+
+    // writes with response end in either characteristicWritten() or
+    // writeFailed(), writes without response are never confirmed
+    virtual void writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse = true) = 0;
+
+    // asks the peer to switch the connection parameters, the ones actually
+    // granted are reported through connectionParametersChanged(). false if
+    // the link cannot take the request (yet)
+    virtual bool requestConnectionParameters(const QLowEnergyConnectionParameters &parameters) { Q_UNUSED(parameters) return false; }
+
+signals:
+    void stateChanged();
+    void mtuChanged(int mtu);
+    void connectionParametersChanged(const QLowEnergyConnectionParameters &parameters);
+    void infoMessage(const QString &message);
+    void errorOccurred(const QString &message);
+
+    void characteristicChanged(const QBluetoothUuid &uuid, const QByteArray &value);
+    void characteristicWritten(const QBluetoothUuid &uuid, const QByteArray &value);
+    void writeFailed(const QBluetoothUuid &uuid);
+    void descriptorWritten(const QBluetoothUuid &uuid, bool notificationsEnabled);
+
+protected:
+    void setState(State state);
+    void setMtu(int mtu);
+
+private:
+    State m_state{State::Disconnected};
+    int m_mtu{defaultAttMtu};
+};
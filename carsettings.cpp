@@ -0,0 +1,155 @@
+#include "carsettings.h"
+
+CarSettings::CarSettings(QObject *parent) :
+    QObject{parent}
+{
+    // m_writing only ever changes along with one of them
+    connect(this, &CarSettings::valuesChanged, this, &CarSettings::currentChanged);
+    connect(this, &CarSettings::pendingChanged, this, &CarSettings::currentChanged);
+}
+
+QVariantMap CarSettings::current() const
+{
+    QVariantMap current = m_values;
+    for (auto iter = m_writing.cbegin(); iter != m_writing.cend(); ++iter)
+        current.insert(iter.key(), iter.value());
+    for (auto iter = m_pending.cbegin(); iter != m_pending.cend(); ++iter)
+        current.insert(iter.key(), iter.value());
+    return current;
+}
+
+QVariant CarSettings::value(const QString &key, const QVariant &defaultValue) const
+{
+    const auto pending = m_pending.constFind(key);
+    if (pending != m_pending.constEnd())
+        return *pending;
+
+    const auto writing = m_writing.constFind(key);
+    if (writing != m_writing.constEnd())
+        return *writing;
+
+    return m_values.value(key, defaultValue);
+}
+
+void CarSettings::set(const QString &key, const QVariant &value)
+{
+    const auto confirmed = m_values.constFind(key);
+    if (confirmed != m_values.constEnd() && *confirmed == value)
+    {
+        // edited back to what the car already has
+        if (m_pending.remove(key))
+            emit pendingChanged();
+        return;
+    }
+
+    const auto pending = m_pending.constFind(key);
+    if (pending != m_pending.constEnd() && *pending == value)
+        return;
+
+    m_pending.insert(key, value);
+    emit pendingChanged();
+}
+
+void CarSettings::setAll(const QVariantMap &values)
+{
+    bool changed{};
+    for (auto iter = values.cbegin(); iter != values.cend(); ++iter)
+    {
+        const auto confirmed = m_values.constFind(iter.key());
+        if (confirmed != m_values.constEnd() && *confirmed == iter.value())
+            changed |= m_pending.remove(iter.key()) > 0;
+        else if (m_pending.value(iter.key()) != iter.value())
+        {
+            m_pending.insert(iter.key(), iter.value());
+            changed = true;
+        }
+    }
+
+    if (changed)
+        emit pendingChanged();
+}
+
+void CarSettings::discard()
+{
+    if (m_pending.isEmpty())
+        return;
+
+    m_pending.clear();
+    emit pendingChanged();
+}
+
+bool CarSettings::apply()
+{
+    if (m_busy || m_pending.isEmpty())
+        return false;
+
+    m_writing = m_pending;
+    m_pending.clear();
+    m_transaction++;
+
+    setBusy(true);
+    emit pendingChanged();
+    emit transactionRequested(m_transaction, m_writing);
+    return true;
+}
+
+void CarSettings::finishTransaction(int transaction, bool success)
+{
+    if (!m_busy || transaction != m_transaction)
+        return;
+
+    if (success)
+    {
+        for (auto iter = m_writing.cbegin(); iter != m_writing.cend(); ++iter)
+        {
+            m_values.insert(iter.key(), iter.value());
+
+            // staged again with the value that just got confirmed
+            const auto pending = m_pending.constFind(iter.key());
+            if (pending != m_pending.constEnd() && *pending == iter.value())
+                m_pending.remove(iter.key());
+        }
+        emit valuesChanged();
+    }
+    else
+    {
+        // back to pending, unless edited again meanwhile
+        for (auto iter = m_writing.cbegin(); iter != m_writing.cend(); ++iter)
+            if (!m_pending.contains(iter.key()))
+                m_pending.insert(iter.key(), iter.value());
+    }
+
+    m_writing.clear();
+    emit pendingChanged();
+    setBusy(false);
+    emit applied(success);
+}
+
+void CarSettings::clear()
+{
+    const bool hadValues = !m_values.isEmpty();
+    const bool hadPending = !m_pending.isEmpty();
+    const bool hadWriting = !m_writing.isEmpty();
+
+    m_values.clear();
+    m_pending.clear();
+    m_writing.clear();
+    setBusy(false);
+
+    if (hadValues)
+        emit valuesChanged();
+    if (hadPending)
+        emit pendingChanged();
+    // both of the above already announce current
+    else if (hadWriting && !hadValues)
+        emit currentChanged();
+}
+
+void CarSettings::setBusy(bool busy)
+{
+    if (m_busy == busy)
+        return;
+
+    m_busy = busy;
+    emit busyChanged();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// system includes
+#include <cstdint>
+
+// Qt includes
+#include <QObject>
+#include <QVariantMap>
+#include <QtQml/qqml.h>
+
+// Local mirror of the settings this app wrote to the connected car plus the
+// edits not written yet. The firmware offers no way to read settings back,
+// anything not written since connecting is unknown. Edits are staged with
+// set(), apply() writes everything that differs from the mirror as one
+// transaction (see settingsframe.h) and the mirror only takes the new values
+// once the car confirmed all of it. Lives on the GUI thread, DeviceHandler
+// carries the transactions to its worker.
+class CarSettings : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap values READ values NOTIFY valuesChanged)
+    Q_PROPERTY(QVariantMap pending READ pending NOTIFY pendingChanged)
+    // what value() returns for every known key, for bindings
+    Q_PROPERTY(QVariantMap current READ current NOTIFY currentChanged)
+    Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
+    QML_ELEMENT
+    QML_UNCREATABLE("CarSettings is owned by DeviceHandler")
+
+public:
+    explicit CarSettings(QObject *parent = nullptr);
+
+    // confirmed by the car, only what this app wrote since connecting
+    const QVariantMap &values() const { return m_values; }
+    // staged edits differing from values()
+    const QVariantMap &pending() const { return m_pending; }
+    QVariantMap current() const;
+    // a transaction is being written
+    bool busy() const { return m_busy; }
+
+    // the pending edit if there is one, then the value being written, the
+    // confirmed value otherwise. Not re-evaluated by bindings, they should
+    // use current instead.
+    Q_INVOKABLE QVariant value(const QString &key, const QVariant &defaultValue = {}) const;
+
+    Q_INVOKABLE void set(const QString &key, const QVariant &value);
+    // stages a whole profile at once
+    Q_INVOKABLE void setAll(const QVariantMap &values);
+    Q_INVOKABLE void discard();
+
+    // false if nothing is pending or a transaction is still running
+    Q_INVOKABLE bool apply();
+
+    // called by DeviceHandler when the worker reports the outcome
+    void finishTransaction(int transaction, bool success);
+    // a different car, nothing known about its settings
+    void clear();
+
+signals:
+    void valuesChanged();
+    void pendingChanged();
+    void currentChanged();
+    void busyChanged();
+    void transactionRequested(int transaction, const QVariantMap &changes);
+    void applied(bool success);
+
+private:
+    void setBusy(bool busy);
+
+    QVariantMap m_values;
+    QVariantMap m_pending;
+    // being written
+    QVariantMap m_writing;
+    uint8_t m_transaction{};
+    bool m_busy{};
+};
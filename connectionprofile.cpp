@@ -0,0 +1,39 @@
+#include "connectionprofile.h"
+
+namespace {
+QLowEnergyConnectionParameters makeParameters(double minimumInterval, double maximumInterval, int latency, int supervisionTimeout)
+{
+    QLowEnergyConnectionParameters parameters;
+    parameters.setIntervalRange(minimumInterval, maximumInterval);
+    parameters.setLatency(latency);
+    parameters.setSupervisionTimeout(supervisionTimeout);
+    return parameters;
+}
+}
+
+QLowEnergyConnectionParameters connectionParameters(ConnectionProfile profile)
+{
+    switch (profile)
+    {
+    case ConnectionProfile::LowLatency:
+        // 7.5 ms is the shortest interval the spec allows
+        return makeParameters(7.5, 15., 0, 2000);
+    case ConnectionProfile::Balanced:
+        return makeParameters(30., 50., 0, 4000);
+    case ConnectionProfile::LowPower:
+    default:
+        // the car may skip up to 4 intervals when it has nothing to send
+        return makeParameters(100., 200., 4, 6000);
+    }
+}
+
+QString connectionProfileName(ConnectionProfile profile)
+{
+    switch (profile)
+    {
+    case ConnectionProfile::LowLatency: return QStringLiteral("lowLatency");
+    case ConnectionProfile::Balanced: return QStringLiteral("balanced");
+    case ConnectionProfile::LowPower:
+    default: return QStringLiteral("lowPower");
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Qt includes
+#include <QString>
+#include <QLowEnergyConnectionParameters>
+
+// Connection parameter sets requested depending on what the app is doing
+// with the car. Intervals and supervision timeouts are in milliseconds.
+enum class ConnectionProfile {
+    // nothing on screen needs fresh data, lets the radio sleep
+    LowPower,
+    // telemetry is shown, but nobody is driving
+    Balanced,
+    // remote control is active, every interval adds to the control latency
+    LowLatency
+};
+
+QLowEnergyConnectionParameters connectionParameters(ConnectionProfile profile);
+QString connectionProfileName(ConnectionProfile profile);
@@ -3,16 +3,55 @@
 // system includes
 #include <algorithm>
 
+// Qt includes
+#include <QDateTime>
+#include <QSettings>
+
 // local includes
 #include "devicehandler.h"
+#include "bobbycartransport.h"
+
+namespace {
+const QString knownDevicesKey = QStringLiteral("DeviceFinder/knownDevices");
+const QString autoConnectKey = QStringLiteral("DeviceFinder/autoConnect");
+
+// back from a deviceId(), known devices stored by older versions are
+// addresses
+bool parseDeviceId(const QString &deviceId, quint64 &key)
+{
+    if (deviceId.contains(QLatin1Char(':')))
+    {
+        key = QBluetoothAddress{deviceId}.toUInt64();
+        return key != 0;
+    }
+
+    bool ok{};
+    key = deviceId.toULongLong(&ok, 16);
+    return ok;
+}
+}
 
 DeviceFinder::DeviceFinder(QObject *parent):
     QAbstractItemModel{parent},
-    m_deviceDiscoveryAgent{this}
+    m_deviceDiscoveryAgent{this},
+    m_agingTimer{this}
 {
     m_deviceDiscoveryAgent.setLowEnergyDiscoveryTimeout(5000);
 
+    QSettings settings;
+    m_autoConnect = settings.value(autoConnectKey, true).toBool();
+    for (const QString &deviceId : settings.value(knownDevicesKey).toStringList())
+    {
+        quint64 key;
+        if (parseDeviceId(deviceId, key))
+            m_knownDevices.insert(key);
+    }
+
+    m_agingTimer.setInterval(agingInterval);
+    connect(&m_agingTimer, &QTimer::timeout, this, &DeviceFinder::removeStaleDevices);
+
     connect(&m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered, this, &DeviceFinder::addDevice);
+    connect(&m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated, this, &DeviceFinder::updateDevice);
     connect(&m_deviceDiscoveryAgent, qOverload<QBluetoothDeviceDiscoveryAgent::Error>(&QBluetoothDeviceDiscoveryAgent::error),
             this, &DeviceFinder::scanError);
 
@@ -20,6 +59,86 @@ DeviceFinder::DeviceFinder(QObject *parent):
     connect(&m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::canceled, this, &DeviceFinder::scanFinished);
 }
 
+void DeviceFinder::setHandler(DeviceHandler *handler)
+{
+    if (m_handler == handler)
+        return;
+
+    if (m_handler)
+        m_handler->disconnect(this);
+
+    m_handler = handler;
+    m_connectingUnknown = false;
+
+    if (m_handler)
+        connect(m_handler, &DeviceHandler::aliveChanged, this, &DeviceFinder::handlerAliveChanged);
+
+    emit handlerChanged();
+}
+
+void DeviceFinder::setShowAllDevices(bool showAllDevices)
+{
+    if (m_showAllDevices == showAllDevices)
+        return;
+
+    m_showAllDevices = showAllDevices;
+    emit showAllDevicesChanged();
+
+    // the list outlives scans, so what is no longer shown has to go now
+    if (!m_showAllDevices)
+        for (int row = int(m_devices.size()) - 1; row >= 0; row--)
+            if (!isBobbycar(m_devices[row].info))
+                removeDevice(row);
+}
+
+void DeviceFinder::setAutoConnect(bool autoConnect)
+{
+    if (m_autoConnect == autoConnect)
+        return;
+
+    m_autoConnect = autoConnect;
+    QSettings{}.setValue(autoConnectKey, m_autoConnect);
+    emit autoConnectChanged();
+}
+
+QString DeviceFinder::deviceId(const QBluetoothDeviceInfo &device)
+{
+    return QString::number(deviceKey(device), 16);
+}
+
+bool DeviceFinder::findDevice(const QString &deviceId, QBluetoothDeviceInfo &device) const
+{
+    quint64 key;
+    if (!parseDeviceId(deviceId, key))
+        return false;
+
+    const auto iter = m_rows.constFind(key);
+    if (iter == m_rows.cend())
+        return false;
+
+    device = m_devices[*iter].info;
+    return true;
+}
+
+QStringList DeviceFinder::knownDevices() const
+{
+    QStringList deviceIds;
+    deviceIds.reserve(m_knownDevices.size());
+    for (const quint64 key : m_knownDevices)
+        deviceIds.push_back(QString::number(key, 16));
+    return deviceIds;
+}
+
+void DeviceFinder::forgetDevice(const QString &deviceId)
+{
+    quint64 key;
+    if (!parseDeviceId(deviceId, key) || !m_knownDevices.remove(key))
+        return;
+
+    saveKnownDevices();
+    emit knownDevicesChanged();
+}
+
 QModelIndex DeviceFinder::index(int row, int column, const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
@@ -66,10 +185,16 @@ QVariant DeviceFinder::data(const QModelIndex &index, int role) const
     {
     case Qt::DisplayRole:
     case Qt::EditRole:
-    case Qt::UserRole + 1:
-        return device.name();
-    case Qt::UserRole + 2:
-        return device.address().toString();
+    case DeviceNameRole:
+        return device.info.name();
+    case DeviceAddressRole:
+        return device.info.address().toString();
+    case RssiRole:
+        return device.info.rssi();
+    case LastSeenRole:
+        return device.lastSeen;
+    case DeviceIdRole:
+        return deviceId(device.info);
     }
 
     return {};
@@ -94,16 +219,22 @@ QMap<int, QVariant> DeviceFinder::itemData(const QModelIndex &index) const
     const auto &device = m_devices.at(index.row());
 
     return QMap<int, QVariant> {
-        { Qt::UserRole + 1, device.name() },
-        { Qt::UserRole + 2, device.address().toString() }
+        { DeviceNameRole, device.info.name() },
+        { DeviceAddressRole, device.info.address().toString() },
+        { RssiRole, device.info.rssi() },
+        { LastSeenRole, device.lastSeen },
+        { DeviceIdRole, deviceId(device.info) }
     };
 }
 
 QHash<int, QByteArray> DeviceFinder::roleNames() const
 {
     return QHash<int, QByteArray> {
-        { Qt::UserRole + 1, QByteArrayLiteral("deviceName") },
-        { Qt::UserRole + 2, QByteArrayLiteral("deviceAddress") }
+        { DeviceNameRole, QByteArrayLiteral("deviceName") },
+        { DeviceAddressRole, QByteArrayLiteral("deviceAddress") },
+        { RssiRole, QByteArrayLiteral("rssi") },
+        { LastSeenRole, QByteArrayLiteral("lastSeen") },
+        { DeviceIdRole, QByteArrayLiteral("deviceId") }
     };
 }
 
@@ -111,11 +242,35 @@ void DeviceFinder::startSearch()
 {
     clearMessages();
 
-    beginResetModel();
-    m_devices.clear();
-    endResetModel();
+    m_autoConnecting = false;
+
+    const int simulatedDevices = m_handler && m_handler->simulated() ? std::max(1, m_simulatedDevices) : m_simulatedDevices;
+    if (simulatedDevices)
+    {
+        beginResetModel();
+        m_devices.clear();
+        m_rows.clear();
+        endResetModel();
+
+        // nothing to scan for, offer the simulators instead
+        for (int i = 1; i <= simulatedDevices; i++)
+        {
+            QBluetoothDeviceInfo device{QBluetoothAddress{quint64(i)}, QStringLiteral("bobbycar simulator %0").arg(i), 0};
+            device.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+            insertDevice(device);
+        }
+
+        setInfo(tr("Simulated bobbycar available."));
+        return;
+    }
+
+    // the list is kept across scans, cars still advertising stay where they
+    // are and only the ones gone for staleTimeout() are removed
+    removeStaleDevices();
 
     m_deviceDiscoveryAgent.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    m_agingTimer.start();
 
     emit scanningChanged();
     setInfo(tr("Scanning for devices..."));
@@ -127,16 +282,132 @@ void DeviceFinder::addDevice(const QBluetoothDeviceInfo &device)
     if (!(device.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration))
         return;
 
-    //if (!device.name().contains("bobby"))
-    //    return;
+    if (!m_showAllDevices && !isBobbycar(device))
+        return;
 
-    beginInsertRows({}, m_devices.size(), m_devices.size());
-    m_devices.push_back(device);
-    endInsertRows();
+    // the agent reports the same device again for every advertisement
+    if (m_rows.contains(deviceKey(device)))
+    {
+        updateDevice(device, QBluetoothDeviceInfo::Field::All);
+        return;
+    }
+
+    insertDevice(device);
+
+    if (m_autoConnect && !m_autoConnecting && m_knownDevices.contains(deviceKey(device)) &&
+        m_handler && !m_handler->alive())
+    {
+        // no need to wait for the scan timeout, this is the car we want
+        m_autoConnecting = true;
+        setInfo(tr("Known bobbycar found, connecting..."));
+        connectToService(deviceId(device));
+        emit autoConnecting(deviceId(device));
+        return;
+    }
 
     setInfo(tr("Low Energy device found. Scanning more..."));
 }
 
+void DeviceFinder::updateDevice(const QBluetoothDeviceInfo &device, QBluetoothDeviceInfo::Fields updatedFields)
+{
+    const auto iter = m_rows.constFind(deviceKey(device));
+    if (iter == m_rows.cend())
+    {
+        addDevice(device);
+        return;
+    }
+
+    const int row = *iter;
+    auto &entry = m_devices[row];
+    entry.lastSeen = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<int> roles{LastSeenRole};
+
+    if (updatedFields.testFlag(QBluetoothDeviceInfo::Field::RSSI) && entry.info.rssi() != device.rssi())
+    {
+        entry.info.setRssi(device.rssi());
+        roles.push_back(RssiRole);
+    }
+
+    // names only come with some advertisements, never forget a known one
+    if (!device.name().isEmpty() && entry.info.name() != device.name())
+    {
+        entry.info = device;
+        roles.push_back(DeviceNameRole);
+        roles.push_back(Qt::DisplayRole);
+    }
+
+    const QModelIndex index = createIndex(row, 0);
+    emit dataChanged(index, index, roles);
+}
+
+void DeviceFinder::removeStaleDevices()
+{
+    const qint64 oldest = QDateTime::currentMSecsSinceEpoch() - m_staleTimeout;
+
+    for (int row = int(m_devices.size()) - 1; row >= 0; row--)
+        if (m_devices[row].lastSeen < oldest)
+            removeDevice(row);
+}
+
+bool DeviceFinder::isBobbycar(const QBluetoothDeviceInfo &device) const
+{
+    return device.serviceUuids().contains(bobbycarServiceUuid) ||
+           m_knownDevices.contains(deviceKey(device)) ||
+           device.name().contains(QLatin1String("bobby"), Qt::CaseInsensitive);
+}
+
+void DeviceFinder::handlerAliveChanged()
+{
+    if (!m_connectingUnknown || !m_handler->alive())
+        return;
+
+    m_connectingUnknown = false;
+    m_knownDevices.insert(m_connectingKey);
+    saveKnownDevices();
+    emit knownDevicesChanged();
+}
+
+void DeviceFinder::saveKnownDevices() const
+{
+    QSettings{}.setValue(knownDevicesKey, knownDevices());
+}
+
+quint64 DeviceFinder::deviceKey(const QBluetoothDeviceInfo &device)
+{
+    if (!device.address().isNull())
+        return device.address().toUInt64();
+
+    return (quint64{1} << 63) | qHash(device.deviceUuid().toByteArray());
+}
+
+void DeviceFinder::insertDevice(const QBluetoothDeviceInfo &device)
+{
+    if (int(m_devices.size()) >= maxDevices)
+    {
+        const auto iter = std::min_element(std::cbegin(m_devices), std::cend(m_devices), [](const Device &left, const Device &right){
+            return left.lastSeen < right.lastSeen;
+        });
+        removeDevice(int(std::distance(std::cbegin(m_devices), iter)));
+    }
+
+    const int row = int(m_devices.size());
+    beginInsertRows({}, row, row);
+    m_devices.push_back(Device{device, QDateTime::currentMSecsSinceEpoch()});
+    m_rows.insert(deviceKey(device), row);
+    endInsertRows();
+}
+
+void DeviceFinder::removeDevice(int row)
+{
+    beginRemoveRows({}, row, row);
+    m_rows.remove(deviceKey(m_devices[row].info));
+    m_devices.erase(std::begin(m_devices) + row);
+    for (int i = row; i < int(m_devices.size()); i++)
+        m_rows[deviceKey(m_devices[i].info)] = i;
+    endRemoveRows();
+}
+
 void DeviceFinder::scanError(QBluetoothDeviceDiscoveryAgent::Error error)
 {
     switch (error)
@@ -154,6 +425,10 @@ void DeviceFinder::scanError(QBluetoothDeviceDiscoveryAgent::Error error)
 
 void DeviceFinder::scanFinished()
 {
+    // scans may end before the timer fired even once
+    m_agingTimer.stop();
+    removeStaleDevices();
+
     if (m_devices.empty())
         setError(tr("No Low Energy devices found."));
     else
@@ -162,18 +437,15 @@ void DeviceFinder::scanFinished()
     emit scanningChanged();
 }
 
-void DeviceFinder::connectToService(const QString &address)
+void DeviceFinder::connectToService(const QString &deviceId)
 {
     m_deviceDiscoveryAgent.stop();
 
-    auto iter = std::find_if(std::cbegin(m_devices), std::cend(m_devices), [&address](const QBluetoothDeviceInfo &device){
-        return device.address().toString() == address;
-    });
-
-    if (iter == std::cend(m_devices))
+    QBluetoothDeviceInfo device;
+    if (!findDevice(deviceId, device))
     {
-        qWarning() << "could not find address" << address;
-        setError(tr("could not find address %0").arg(address));
+        qWarning() << "could not find device" << deviceId;
+        setError(tr("could not find device %0").arg(deviceId));
         return;
     }
 
@@ -184,7 +456,12 @@ void DeviceFinder::connectToService(const QString &address)
         return;
     }
 
-    m_handler->setDevice(*iter);
+    // only remembered once the connection works, a tapped car that never
+    // answers would otherwise be auto-connected to from then on
+    m_connectingKey = deviceKey(device);
+    m_connectingUnknown = !m_handler->simulated() && !m_simulatedDevices && !m_knownDevices.contains(m_connectingKey);
+
+    m_handler->setDevice(device);
 
     clearMessages();
 }
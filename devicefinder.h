@@ -1,6 +1,7 @@
 #pragma once
 
 // system includes
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -10,6 +11,9 @@
 #include <QVariant>
 #include <QBluetoothDeviceDiscoveryAgent>
 #include <QBluetoothDeviceInfo>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QtQml/qqml.h>
 
 // forward declares
@@ -22,16 +26,39 @@ class DeviceFinder : public QAbstractItemModel
     Q_PROPERTY(DeviceHandler* handler READ handler WRITE setHandler NOTIFY handlerChanged)
     Q_PROPERTY(QString error READ error WRITE setError NOTIFY errorChanged)
     Q_PROPERTY(QString info READ info WRITE setInfo NOTIFY infoChanged)
+    Q_PROPERTY(bool showAllDevices READ showAllDevices WRITE setShowAllDevices NOTIFY showAllDevicesChanged)
+    Q_PROPERTY(bool autoConnect READ autoConnect WRITE setAutoConnect NOTIFY autoConnectChanged)
+    Q_PROPERTY(QStringList knownDevices READ knownDevices NOTIFY knownDevicesChanged)
     QML_ELEMENT
 
 public:
+    enum Roles {
+        DeviceNameRole = Qt::UserRole + 1,
+        DeviceAddressRole,
+        RssiRole,
+        // ms since epoch the device was last advertising
+        LastSeenRole,
+        // what findDevice() and connectToService() take, unlike the address
+        // also unique on platforms hiding it
+        DeviceIdRole
+    };
+
+    // devices not heard of for this long are removed while scanning, when
+    // the scan finishes and when the next one starts, the list itself is
+    // kept across scans
+    static constexpr int defaultStaleTimeout = 30000;
+    // ms between checks for stale devices while scanning
+    static constexpr int agingInterval = 1000;
+    // upper bound for the list, the longest unseen device makes room
+    static constexpr int maxDevices = 256;
+
     DeviceFinder(QObject *parent = nullptr);
 
     bool scanning() const { return m_deviceDiscoveryAgent.isActive(); }
 
     DeviceHandler* handler() { return m_handler; }
     const DeviceHandler* handler() const { return m_handler; }
-    void setHandler(DeviceHandler* handler) { if (m_handler == handler) return; m_handler = handler; emit handlerChanged(); }
+    void setHandler(DeviceHandler* handler);
 
     QString error() const { return m_error; }
     void setError(const QString& error) { if (m_error == error) return; m_error = error; emit errorChanged(); }
@@ -41,6 +68,34 @@ public:
 
     void clearMessages() { setInfo(""); setError(""); }
 
+    // without it only devices advertising the bobbycar service, named like
+    // one or connected before are listed
+    bool showAllDevices() const { return m_showAllDevices; }
+    void setShowAllDevices(bool showAllDevices);
+
+    // connect as soon as a known car shows up, persisted
+    bool autoConnect() const { return m_autoConnect; }
+    void setAutoConnect(bool autoConnect);
+
+    // lists this many simulated cars instead of scanning, at least one when
+    // the handler talks to a simulated transport
+    int simulatedDevices() const { return m_simulatedDevices; }
+    void setSimulatedDevices(int simulatedDevices) { m_simulatedDevices = std::max(0, simulatedDevices); }
+
+    // ms, defaultStaleTimeout unless set
+    int staleTimeout() const { return m_staleTimeout; }
+    void setStaleTimeout(int staleTimeout) { m_staleTimeout = std::max(0, staleTimeout); }
+
+    // the 48 bit address, devices without one (Apple platforms) by their uuid
+    static QString deviceId(const QBluetoothDeviceInfo &device);
+
+    // looks a listed device up by its deviceId()
+    bool findDevice(const QString &deviceId, QBluetoothDeviceInfo &device) const;
+
+    // deviceId()s of cars connected to before, persisted
+    QStringList knownDevices() const;
+    Q_INVOKABLE void forgetDevice(const QString &deviceId);
+
     // QAbstractItemModel interface
     QModelIndex index(int row, int column, const QModelIndex &parent) const override;
     QModelIndex parent(const QModelIndex &child) const override;
@@ -55,20 +110,54 @@ signals:
     void handlerChanged();
     void errorChanged();
     void infoChanged();
+    void showAllDevicesChanged();
+    void autoConnectChanged();
+    void knownDevicesChanged();
+    // emitted when a known car was found and is being connected to
+    void autoConnecting(const QString &deviceId);
 
 public slots:
     void startSearch();
-    void connectToService(const QString &address);
+    void connectToService(const QString &deviceId);
 
 private slots:
     void addDevice(const QBluetoothDeviceInfo &);
+    void updateDevice(const QBluetoothDeviceInfo &device, QBluetoothDeviceInfo::Fields updatedFields);
+    void removeStaleDevices();
+    void handlerAliveChanged();
     void scanError(QBluetoothDeviceDiscoveryAgent::Error error);
     void scanFinished();
 
 private:
+    struct Device
+    {
+        QBluetoothDeviceInfo info;
+        qint64 lastSeen;
+    };
+
+    // see deviceId()
+    static quint64 deviceKey(const QBluetoothDeviceInfo &device);
+
+    bool isBobbycar(const QBluetoothDeviceInfo &device) const;
+    void saveKnownDevices() const;
+    void insertDevice(const QBluetoothDeviceInfo &device);
+    void removeDevice(int row);
+
     DeviceHandler *m_handler{};
     QBluetoothDeviceDiscoveryAgent m_deviceDiscoveryAgent;
-    std::vector<QBluetoothDeviceInfo> m_devices;
+    QTimer m_agingTimer;
+    std::vector<Device> m_devices;
+    QHash<quint64, int> m_rows;
+    QSet<quint64> m_knownDevices;
+    // the car connectToService() was called for, known once the handler
+    // reports it alive
+    quint64 m_connectingKey{};
+    bool m_connectingUnknown{};
+    bool m_showAllDevices{};
+    bool m_autoConnect{true};
+    bool m_autoConnecting{};
+    int m_simulatedDevices{};
+    int m_staleTimeout{defaultStaleTimeout};
     QString m_error;
     QString m_info;
 };
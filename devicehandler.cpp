@@ -1,73 +1,119 @@
 #include "devicehandler.h"
 
+// system includes
+#include <algorithm>
+
 // Qt includes
-#include <QtEndian>
-#include <QRandomGenerator>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QTimerEvent>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTextStream>
 
 // local includes
 #include "deviceinfo.h"
+#include "bletransport.h"
+#include "tracing.h"
 
-namespace {
-const QBluetoothUuid bobbycarServiceUuid{QUuid::fromString(QStringLiteral("0335e46c-f355-4ce6-8076-017de08cee98"))};
-
-const QBluetoothUuid livestatsCharacUuid{QUuid::fromString(QStringLiteral("a48321ea-329f-4eab-a401-30e247211524"))};
-const QBluetoothUuid remotecontrolCharacUuid{QUuid::fromString(QStringLiteral("4201def0-a264-43e6-946b-6b2d9612dfed"))};
+DeviceHandler::DeviceHandler(QObject *parent) :
+    DeviceHandler{nullptr, TelemetryHistory::defaultCapacity, parent}
+{
+}
 
-const QBluetoothUuid settingsSetterUuid{QUuid::fromString(QStringLiteral("4201def1-a264-43e6-946b-6b2d9612dfed"))};
-const QBluetoothUuid wifiListUuid{QUuid::fromString(QStringLiteral("4201def2-a264-43e6-946b-6b2d9612dfed"))};
+DeviceHandler::DeviceHandler(QThread &workerThread, int historyCapacity, QObject *parent) :
+    DeviceHandler{&workerThread, historyCapacity, parent}
+{
 }
 
-DeviceHandler::DeviceHandler(QObject *parent) :
+DeviceHandler::DeviceHandler(QThread *workerThread, int historyCapacity, QObject *parent) :
     BluetoothBaseClass(parent),
-    m_foundBobbycarService(false)
+    m_workerThread{workerThread ? workerThread : &m_ownWorkerThread},
+    m_history{historyCapacity},
+    m_recorder{this},
+    m_carSettings{this}
 {
+    qRegisterMetaType<LatencyStats>();
+    qRegisterMetaType<GattQueueStats>();
+    qRegisterMetaType<QVector<WifiNetwork>>();
+
+    m_handoff.clock.start();
+
+    m_worker = new DeviceWorker{m_handoff, m_recorder};
+    m_worker->moveToThread(m_workerThread);
+    if (!workerThread)
+        connect(&m_ownWorkerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    connect(m_worker, &DeviceWorker::infoMessage, this, &DeviceHandler::setInfo);
+    connect(m_worker, &DeviceWorker::errorOccurred, this, &DeviceHandler::workerErrorOccurred);
+    connect(m_worker, &DeviceWorker::linkChanged, this, &DeviceHandler::workerLinkChanged);
+    connect(m_worker, &DeviceWorker::livestatsFormatChanged, this, &DeviceHandler::workerLivestatsFormatChanged);
+    connect(m_worker, &DeviceWorker::mtuChanged, this, &DeviceHandler::workerMtuChanged);
+    connect(m_worker, &DeviceWorker::livestatsDiscardedChanged, this, &DeviceHandler::workerLivestatsDiscardedChanged);
+    connect(m_worker, &DeviceWorker::connectionProfileChanged, this, &DeviceHandler::workerConnectionProfileChanged);
+    connect(m_worker, &DeviceWorker::connectionParametersChanged, this, &DeviceHandler::workerConnectionParametersChanged);
+    if (!workerThread)
+        connect(m_worker, &DeviceWorker::telemetryAvailable, this, &DeviceHandler::drainTelemetry);
+    connect(m_worker, &DeviceWorker::remoteControlActiveChanged, this, &DeviceHandler::workerRemoteControlActiveChanged);
+    connect(m_worker, &DeviceWorker::controlStatsChanged, this, &DeviceHandler::workerControlStatsChanged);
+    connect(m_worker, &DeviceWorker::latencyStatsChanged, this, &DeviceHandler::workerLatencyStatsChanged);
+    connect(m_worker, &DeviceWorker::gattQueueStatsChanged, this, &DeviceHandler::workerGattQueueStatsChanged);
+    connect(m_worker, &DeviceWorker::settingsApplied, &m_carSettings, &CarSettings::finishTransaction);
+    connect(m_worker, &DeviceWorker::wifiListReceived, this, &DeviceHandler::wifiListReceived);
+
+    connect(&m_carSettings, &CarSettings::transactionRequested, this, [this](int transaction, const QVariantMap &changes) {
+        post([worker = m_worker, transaction, changes]() {
+            worker->applySettings(transaction, changes);
+        });
+    });
+
+    if (!workerThread)
+    {
+        m_ownWorkerThread.setObjectName(QStringLiteral("DeviceWorker"));
+        m_ownWorkerThread.start(QThread::HighPriority);
+    }
+
+    setTransport(new BleTransport);
+}
+
+DeviceHandler::~DeviceHandler()
+{
+    if (m_workerThread == &m_ownWorkerThread)
+    {
+        m_ownWorkerThread.quit();
+        m_ownWorkerThread.wait();
+    }
+    else
+    {
+        // the worker uses the handoff and recorder of this handler
+        QMetaObject::invokeMethod(m_worker, [worker = m_worker]() {
+            delete worker;
+        }, Qt::BlockingQueuedConnection);
+    }
 }
 
 void DeviceHandler::setDevice(const QBluetoothDeviceInfo &device)
 {
     clearMessages();
-    m_currentDevice = device;
+    m_carSettings.clear();
 
-    // Disconnect and delete old connection
-    if (m_control)
-    {
-        m_control->disconnectFromDevice();
-        delete m_control;
-        m_control = nullptr;
-    }
+    post([worker = m_worker, device, addressType = m_addressType]() {
+        worker->connectToDevice(device, addressType);
+    });
+}
 
-    // Create new controller and connect it if device available
-    if (m_currentDevice.isValid())
-    {
-        // Make connections
-        m_control = QLowEnergyController::createCentral(m_currentDevice, this);
-        m_control->setRemoteAddressType(m_addressType);
-
-        connect(m_control, &QLowEnergyController::serviceDiscovered,
-                this, &DeviceHandler::serviceDiscovered);
-        connect(m_control, &QLowEnergyController::discoveryFinished,
-                this, &DeviceHandler::serviceScanDone);
-
-        connect(m_control, static_cast<void (QLowEnergyController::*)(QLowEnergyController::Error)>(&QLowEnergyController::error),
-                this, [this](QLowEnergyController::Error error) {
-            Q_UNUSED(error);
-            setError("Cannot connect to remote device.");
-        });
-        connect(m_control, &QLowEnergyController::connected, this, [this]() {
-            setInfo("Controller connected. Search services...");
-            m_control->discoverServices();
-        });
-        connect(m_control, &QLowEnergyController::disconnected, this, [this]() {
-            setError("LowEnergy controller disconnected");
-        });
+void DeviceHandler::setTransport(BobbycarTransport *transport)
+{
+    if (!transport)
+        return;
 
-        // Connect
-        m_control->connectToDevice();
-    }
+    m_simulated = transport->isSimulated();
+
+    transport->setParent(nullptr);
+    transport->moveToThread(m_workerThread);
+    post([worker = m_worker, transport]() {
+        worker->setTransport(transport);
+    });
+
+    emit transportChanged();
 }
 
 void DeviceHandler::setAddressType(AddressType type)
@@ -91,280 +137,394 @@ DeviceHandler::AddressType DeviceHandler::addressType() const
     return DeviceHandler::AddressType::PublicAddress;
 }
 
-bool DeviceHandler::alive() const
+void DeviceHandler::setHistoryCapacity(int historyCapacity)
 {
-    if (m_service)
-        return m_service->state() == QLowEnergyService::ServiceDiscovered;
+    if (m_history.capacity() == historyCapacity)
+        return;
 
-    return false;
+    m_history.setCapacity(historyCapacity);
+    emit historyCapacityChanged();
 }
 
-void DeviceHandler::setRemoteControlActive(bool remoteControlActive)
+void DeviceHandler::setControlWriteMode(ControlWriteMode controlWriteMode)
 {
-    if (!remoteControlActive && m_timerId != -1)
+    if (m_controlWriteMode == controlWriteMode)
+        return;
+
+    m_controlWriteMode = controlWriteMode;
+    emit controlWriteModeChanged();
+    postControlSettings();
+}
+
+void DeviceHandler::setMaxControlWritesInFlight(int maxControlWritesInFlight)
+{
+    maxControlWritesInFlight = std::max(1, maxControlWritesInFlight);
+    if (m_controlSettings.maxWritesInFlight == maxControlWritesInFlight)
+        return;
+
+    m_controlSettings.maxWritesInFlight = maxControlWritesInFlight;
+    emit maxControlWritesInFlightChanged();
+    postControlSettings();
+}
+
+void DeviceHandler::resetControlStats()
+{
+    post([worker = m_worker]() {
+        worker->resetControlStats();
+    });
+}
+
+void DeviceHandler::resetLatencyStats()
+{
+    post([worker = m_worker]() {
+        worker->resetLatencyStats();
+    });
+}
+
+bool DeviceHandler::dumpLatencyStats(const QString &fileName)
+{
+    QString path = fileName;
+    if (path.isEmpty())
     {
-        killTimer(m_timerId);
-        m_timerId = -1;
-        emit remoteControlActiveChanged();
-
-        if (m_service && m_remotecontrolCharacteristic.isValid())
-        {
-            m_remoteControlFrontLeft = 0;
-            m_remoteControlFrontRight = 0;
-            m_remoteControlBackLeft = 0;
-            m_remoteControlBackRight = 0;
-
-            sendRemoteControl();
-        }
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir{}.mkpath(dir);
+        path = dir + QStringLiteral("/latency-") + QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")) + QStringLiteral(".txt");
     }
-    else if (remoteControlActive && m_timerId == -1 && m_service && m_remotecontrolCharacteristic.isValid())
+
+    QFile file{path};
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
     {
-        m_timerId = startTimer(100);
-        emit remoteControlActiveChanged();
+        setError(tr("Could not write %0: %1").arg(path, file.errorString()));
+        return false;
     }
-}
 
-void DeviceHandler::timerEvent(QTimerEvent *event)
-{
-    if (event->timerId() == m_timerId)
+    // a rare diagnostic call, briefly waiting for the worker is fine here
+    LatencyHistograms histograms;
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, &histograms]() {
+        histograms = worker->latencyHistograms();
+    }, Qt::BlockingQueuedConnection);
+
+    QTextStream stream{&file};
+    histograms.controlRoundTrip.write(stream, "controlRoundTrip");
+    histograms.controlLatency.write(stream, "controlLatency");
+    histograms.livestatsInterval.write(stream, "livestatsInterval");
+    stream.flush();
+
+    if (stream.status() != QTextStream::Ok)
     {
-        if (!m_service || !m_remotecontrolCharacteristic.isValid())
-        {
-            killTimer(m_timerId);
-            m_timerId = -1;
-            emit remoteControlActiveChanged();
-            return;
-        }
-
-        if (m_waitingForWrite)
-            qWarning() << "still pending";
-        else
-            sendRemoteControl();
+        setError(tr("Could not write %0: %1").arg(path, file.errorString()));
+        return false;
     }
-    else
-        BluetoothBaseClass::timerEvent(event);
+
+    setInfo(tr("Latency statistics written to %0").arg(path));
+    return true;
 }
 
-void DeviceHandler::disconnectService()
+bool DeviceHandler::tracing() const
 {
-    m_foundBobbycarService = false;
+    return TraceRing::instance().enabled();
+}
 
-    //disable notifications
-    if (m_service)
-    {
-        if (m_notificationDescLivestats.isValid() && m_notificationDescLivestats.value() == QByteArray::fromHex("0100"))
-            m_service->writeDescriptor(m_notificationDescLivestats, QByteArray::fromHex("0000"));
+void DeviceHandler::setTracing(bool tracing)
+{
+    if (TraceRing::instance().enabled() == tracing)
+        return;
 
-        disconnectInternal();
-    }
+    TraceRing::instance().setEnabled(tracing);
+    emit tracingChanged();
 }
 
-void DeviceHandler::disconnectInternal()
+bool DeviceHandler::dumpTrace(const QString &fileName)
 {
-    if (!m_notificationDescLivestats.isValid())
+    QString path = fileName;
+    if (path.isEmpty())
     {
-        //disabled notifications -> assume disconnect intent
-        if (m_control)
-            m_control->disconnectFromDevice();
-
-        if (m_service)
-        {
-            delete m_service;
-            m_service = nullptr;
-        }
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir{}.mkpath(dir);
+        path = dir + QStringLiteral("/trace-") + QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")) + QStringLiteral(".txt");
     }
-}
 
-void DeviceHandler::serviceDiscovered(const QBluetoothUuid &gatt)
-{
-    if (gatt == bobbycarServiceUuid)
+    // the ring is read while the worker keeps recording, no need to wait for it
+    QString errorString;
+    if (!TraceRing::instance().dump(path, errorString))
     {
-        setInfo("Bobbycar service discovered. Waiting for service scan to be done...");
-        m_foundBobbycarService = true;
+        setError(tr("Could not write %0: %1").arg(path, errorString));
+        return false;
     }
+
+    m_lastTraceDump.start();
+    setInfo(tr("Trace written to %0").arg(path));
+    return true;
 }
 
-void DeviceHandler::serviceScanDone()
+void DeviceHandler::setControlDeadband(int controlDeadband)
 {
-    setInfo("Service scan done.");
+    controlDeadband = std::max(0, controlDeadband);
+    if (m_controlSettings.deadband == controlDeadband)
+        return;
 
-    // Delete old service if available
-    if (m_service)
-    {
-        delete m_service;
-        m_service = nullptr;
-    }
+    m_controlSettings.deadband = controlDeadband;
+    emit controlSchedulerChanged();
+    postControlSettings();
+}
 
-    // If bobbycarService found, create new service
-    if (m_foundBobbycarService)
-        m_service = m_control->createServiceObject(bobbycarServiceUuid, this);
+void DeviceHandler::setControlMaxRate(int controlMaxRate)
+{
+    controlMaxRate = std::clamp(controlMaxRate, 1, 1000);
+    if (m_controlSettings.maxRate == controlMaxRate)
+        return;
 
-    if (m_service)
-    {
-        connect(m_service, &QLowEnergyService::stateChanged, this, &DeviceHandler::serviceStateChanged);
-        connect(m_service, &QLowEnergyService::characteristicChanged, this, &DeviceHandler::updateBobbycarValue);
-        connect(m_service, &QLowEnergyService::descriptorWritten, this, &DeviceHandler::confirmedDescriptorWrite);
-        connect(m_service, &QLowEnergyService::characteristicWritten, this, &DeviceHandler::confirmedCharacteristicWrite);
-        m_service->discoverDetails();
-    }
-    else
-    {
-        setError("Bobbycar Service not found.");
-    }
+    m_controlSettings.maxRate = controlMaxRate;
+    emit controlSchedulerChanged();
+    postControlSettings();
 }
 
-void DeviceHandler::serviceStateChanged(QLowEnergyService::ServiceState s)
+void DeviceHandler::setControlKeepaliveInterval(int controlKeepaliveInterval)
 {
-    qDebug() << "serviceStateChanged()" << s;
+    controlKeepaliveInterval = std::max(1, controlKeepaliveInterval);
+    if (m_controlSettings.keepaliveInterval == controlKeepaliveInterval)
+        return;
 
-    if (m_timerId != -1)
+    m_controlSettings.keepaliveInterval = controlKeepaliveInterval;
+    emit controlSchedulerChanged();
+    postControlSettings();
+}
+
+void DeviceHandler::setRemoteControlActive(bool remoteControlActive)
+{
+    // the worker confirms through remoteControlActiveChanged
+    post([worker = m_worker, remoteControlActive]() {
+        worker->setRemoteControlActive(remoteControlActive);
+    });
+}
+
+void DeviceHandler::setLivedataVisible(bool livedataVisible)
+{
+    if (m_livedataVisible == livedataVisible)
+        return;
+
+    m_livedataVisible = livedataVisible;
+    emit livedataVisibleChanged();
+
+    post([worker = m_worker, livedataVisible]() {
+        worker->setLivedataVisible(livedataVisible);
+    });
+}
+
+void DeviceHandler::setRemoteControl(int frontLeft, int frontRight, int backLeft, int backRight)
+{
+    m_remoteControl = {frontLeft, frontRight, backLeft, backRight};
+    publishSetpoints();
+}
+
+void DeviceHandler::requestWifiList(int scan)
+{
+    post([worker = m_worker, scan]() {
+        worker->requestWifiList(scan);
+    });
+}
+
+void DeviceHandler::resetTrip()
+{
+    m_metrics.resetTrip();
+    emit telemetryChanged();
+}
+
+void DeviceHandler::disconnectService()
+{
+    post([worker = m_worker]() {
+        worker->disconnectFromDevice();
+    });
+}
+
+void DeviceHandler::injectLivestats(const QByteArray &value, qint64 timestamp)
+{
+    // the value may point into a mapped file, hand over a deep copy
+    post([worker = m_worker, value = QByteArray{value.constData(), value.size()}, timestamp]() {
+        worker->injectLivestats(value, timestamp);
+    });
+}
+
+void DeviceHandler::publishSetpoints()
+{
+    m_handoff.setpoints.publish(TimedSetpoints{m_remoteControl, m_handoff.clock.nsecsElapsed() / 1000});
+
+    if (!m_handoff.setpointsWakeup.exchange(true))
+        post([worker = m_worker]() {
+            worker->takeSetpoints();
+        });
+}
+
+void DeviceHandler::postControlSettings()
+{
+    ControlSettings settings = m_controlSettings;
+    settings.unacknowledgedWrite = m_controlWriteMode == ControlWriteMode::UnacknowledgedWrite;
+
+    post([worker = m_worker, settings]() {
+        worker->setControlSettings(settings);
+    });
+}
+
+bool DeviceHandler::drainTelemetry()
+{
+    m_handoff.telemetryWakeup.store(false);
+
+    TelemetrySnapshot telemetry;
+    int received{};
+    while (m_handoff.telemetry.pop(telemetry))
     {
-        killTimer(m_timerId);
-        m_timerId = -1;
-        emit remoteControlActiveChanged();
+        m_history.append(telemetry);
+        m_metrics.update(telemetry);
+        received++;
     }
 
-    m_waitingForWrite = false;
+    BOBBYCAR_TRACE(lcTelemetry, TraceEvent::TelemetryDrained, received, 0);
 
-    switch (s)
-    {
-    case QLowEnergyService::DiscoveringServices:
-        setInfo(tr("Discovering services..."));
-        break;
-    case QLowEnergyService::ServiceDiscovered:
-    {
-        setInfo(tr("Service discovered."));
-
-        if (const QLowEnergyCharacteristic hrChar = m_service->characteristic(livestatsCharacUuid); hrChar.isValid())
-        {
-            m_notificationDescLivestats = hrChar.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
-            if (m_notificationDescLivestats.isValid())
-                m_service->writeDescriptor(m_notificationDescLivestats, QByteArray::fromHex("0100"));
-        }
-        else
-        {
-            setError("livestatsCharacUuid not found.");
-            break;
-        }
-
-        m_remotecontrolCharacteristic = m_service->characteristic(remotecontrolCharacUuid);
-        if (!m_remotecontrolCharacteristic.isValid())
-        {
-            setError("remotecontrolCharacUuid not found.");
-            break;
-        }
+    // bindings only ever see the newest complete snapshot
+    if (received)
+        applyTelemetry(telemetry);
 
-        break;
-    }
-    default:
-        //nothing for now
-        break;
-    }
+    return received;
+}
+
+void DeviceHandler::applyTelemetry(const TelemetrySnapshot &telemetry)
+{
+    clearMessages();
 
+    const Livestats previous = m_telemetry.livestats();
+    m_telemetry = telemetry;
+    const Livestats &livestats = m_telemetry.livestats();
+
+    if (livestats.frontVoltage != previous.frontVoltage)
+        emit frontVoltageChanged();
+    if (livestats.backVoltage != previous.backVoltage)
+        emit backVoltageChanged();
+    if (livestats.frontTemperature != previous.frontTemperature)
+        emit frontTemperatureChanged();
+    if (livestats.backTemperature != previous.backTemperature)
+        emit backTemperatureChanged();
+    if (livestats.frontLeftError != previous.frontLeftError)
+        emit frontLeftErrorChanged();
+    if (livestats.frontRightError != previous.frontRightError)
+        emit frontRightErrorChanged();
+    if (livestats.backLeftError != previous.backLeftError)
+        emit backLeftErrorChanged();
+    if (livestats.backRightError != previous.backRightError)
+        emit backRightErrorChanged();
+    if (livestats.frontLeftSpeed != previous.frontLeftSpeed)
+        emit frontLeftSpeedChanged();
+    if (livestats.frontRightSpeed != previous.frontRightSpeed)
+        emit frontRightSpeedChanged();
+    if (livestats.backLeftSpeed != previous.backLeftSpeed)
+        emit backLeftSpeedChanged();
+    if (livestats.backRightSpeed != previous.backRightSpeed)
+        emit backRightSpeedChanged();
+    if (livestats.frontLeftDcLink != previous.frontLeftDcLink)
+        emit frontLeftDcLinkChanged();
+    if (livestats.frontRightDcLink != previous.frontRightDcLink)
+        emit frontRightDcLinkChanged();
+    if (livestats.backLeftDcLink != previous.backLeftDcLink)
+        emit backLeftDcLinkChanged();
+    if (livestats.backRightDcLink != previous.backRightDcLink)
+        emit backRightDcLinkChanged();
+
+    emit telemetryChanged();
+}
+
+void DeviceHandler::workerLinkChanged(bool alive, bool unacknowledgedWriteSupported)
+{
+    m_unacknowledgedWriteSupported = unacknowledgedWriteSupported;
+    emit controlWriteModeChanged();
+
+    if (m_alive == alive)
+        return;
+
+    m_alive = alive;
     emit aliveChanged();
 }
 
-void DeviceHandler::updateBobbycarValue(const QLowEnergyCharacteristic &c, const QByteArray &value)
+void DeviceHandler::workerLivestatsFormatChanged(bool binary)
 {
-    //qDebug() << "updateBobbycarValue";
-    //logAddr(c.uuid());
+    if (m_binaryLivestats == binary)
+        return;
 
-    if (c.uuid() == livestatsCharacUuid)
-    {
-        QJsonParseError error;
-        QJsonDocument doc = QJsonDocument::fromJson(value, &error);
-        if (error.error != QJsonParseError::NoError)
-        {
-            qWarning() << "could not parse livestats" << error.errorString();
-            return;
-        }
-
-        clearMessages();
-
-        const QJsonObject &obj = doc.object();
-
-        {
-            const QJsonArray &arr = obj.value("v").toArray();
-            m_frontVoltage = arr.at(0).toDouble();
-            emit frontVoltageChanged();
-            m_backVoltage = arr.at(1).toDouble();
-            emit backVoltageChanged();
-        }
-        {
-            const QJsonArray &arr = obj.value("t").toArray();
-            m_frontTemperature = arr.at(0).toDouble();
-            emit frontTemperatureChanged();
-            m_backTemperature = arr.at(1).toDouble();
-            emit backTemperatureChanged();
-        }
-        {
-            const QJsonArray &arr = obj.value("e").toArray();
-            m_frontLeftError = arr.at(0).toInt();
-            emit frontLeftErrorChanged();
-            m_frontRightError = arr.at(1).toInt();
-            emit frontRightErrorChanged();
-            m_backLeftError = arr.at(2).toInt();
-            emit backLeftErrorChanged();
-            m_backRightError = arr.at(3).toInt();
-            emit backRightErrorChanged();
-        }
-        {
-            const QJsonArray &arr = obj.value("s").toArray();
-            m_frontLeftSpeed = arr.at(0).toDouble();
-            emit frontLeftSpeedChanged();
-            m_frontRightSpeed = arr.at(1).toDouble();
-            emit frontRightSpeedChanged();
-            m_backLeftSpeed = arr.at(2).toDouble();
-            emit backLeftSpeedChanged();
-            m_backRightSpeed = arr.at(3).toDouble();
-            emit backRightSpeedChanged();
-        }
-        {
-            const QJsonArray &arr = obj.value("a").toArray();
-            m_frontLeftDcLink = arr.at(0).toDouble();
-            emit frontLeftDcLinkChanged();
-            m_frontRightDcLink = arr.at(1).toDouble();
-            emit frontRightDcLinkChanged();
-            m_backLeftDcLink = arr.at(2).toDouble();
-            emit backLeftDcLinkChanged();
-            m_backRightDcLink = arr.at(3).toDouble();
-            emit backRightDcLinkChanged();
-        }
-    }
-    else
-        qWarning() << "unknown uuid" << c.uuid();
+    m_binaryLivestats = binary;
+    emit livestatsFormatChanged();
 }
 
-void DeviceHandler::confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value)
+void DeviceHandler::workerMtuChanged(int mtu)
 {
-    qDebug() << "confirmedDescriptorWrite" << d.uuid() << value;
-    if (d.isValid() && value == QByteArray::fromHex("0000"))
-    {
-        if (d == m_notificationDescLivestats)
-            m_notificationDescLivestats = {};
+    if (m_mtu == mtu)
+        return;
 
-        disconnectInternal();
-    }
+    m_mtu = mtu;
+    emit mtuChanged();
 }
 
-void DeviceHandler::confirmedCharacteristicWrite(const QLowEnergyCharacteristic &info, const QByteArray &value)
+void DeviceHandler::workerLivestatsDiscardedChanged(int recordsDiscarded)
 {
-    Q_UNUSED(value)
-    qDebug() << "confirmedCharacteristicWrite";
+    if (m_livestatsRecordsDiscarded == recordsDiscarded)
+        return;
+
+    m_livestatsRecordsDiscarded = recordsDiscarded;
+    emit livestatsRecordsDiscardedChanged();
+}
 
-    if (info == m_remotecontrolCharacteristic)
-        m_waitingForWrite = false;
+void DeviceHandler::workerConnectionProfileChanged(const QString &profile)
+{
+    if (m_connectionProfile == profile)
+        return;
+
+    m_connectionProfile = profile;
+    emit connectionProfileChanged();
+}
+
+void DeviceHandler::workerConnectionParametersChanged(double interval, int latency, int supervisionTimeout)
+{
+    m_connectionInterval = interval;
+    m_connectionLatency = latency;
+    m_supervisionTimeout = supervisionTimeout;
+    emit connectionParametersChanged();
+}
+
+void DeviceHandler::workerRemoteControlActiveChanged(bool remoteControlActive)
+{
+    if (m_remoteControlActive == remoteControlActive)
+        return;
+
+    m_remoteControlActive = remoteControlActive;
+    emit remoteControlActiveChanged();
+}
+
+void DeviceHandler::workerControlStatsChanged(int writesInFlight, int framesSent, int framesSuperseded, int framesDropped)
+{
+    m_controlWritesInFlight = writesInFlight;
+    m_controlFramesSent = framesSent;
+    m_controlFramesSuperseded = framesSuperseded;
+    m_controlFramesDropped = framesDropped;
+    emit controlStatsChanged();
+}
+
+void DeviceHandler::workerLatencyStatsChanged(const LatencyStats &controlRoundTrip, const LatencyStats &controlLatency, const LatencyStats &livestatsInterval)
+{
+    m_controlRoundTrip = controlRoundTrip;
+    m_controlLatency = controlLatency;
+    m_livestatsInterval = livestatsInterval;
+    emit latencyStatsChanged();
+}
+
+void DeviceHandler::workerGattQueueStatsChanged(const GattQueueStats &stats)
+{
+    m_gattQueue = stats;
+    emit gattQueueChanged();
 }
 
-void DeviceHandler::sendRemoteControl()
+void DeviceHandler::workerErrorOccurred(const QString &message)
 {
-    m_waitingForWrite = true;
+    // keeps the events leading up to the error, the error itself is set last
+    // so it stays visible even if the dump failed
+    if (tracing() && (!m_lastTraceDump.isValid() || m_lastTraceDump.hasExpired(minTraceDumpInterval)))
+        dumpTrace();
 
-    qDebug() << "writeCharacteristic()";
-    m_service->writeCharacteristic(m_remotecontrolCharacteristic, QJsonDocument{QJsonObject {
-        {"fl", m_remoteControlFrontLeft},
-        {"fr", m_remoteControlFrontRight},
-        {"bl", m_remoteControlBackLeft},
-        {"br", m_remoteControlBackRight}
-    }}.toJson(QJsonDocument::Compact));
+    setError(message);
 }
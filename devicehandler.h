@@ -1,14 +1,28 @@
 #pragma once
 
+// system includes
+#include <utility>
+
 // Qt includes
 #include <QDateTime>
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QVector>
+#include <QBluetoothDeviceInfo>
 #include <QLowEnergyController>
-#include <QLowEnergyService>
 
 // local includes
 #include "bluetoothbaseclass.h"
+#include "bobbycartransport.h"
+#include "livestats.h"
+#include "remotecontrolframe.h"
+#include "telemetrysnapshot.h"
+#include "telemetryhistory.h"
+#include "drivingmetrics.h"
+#include "sessionrecorder.h"
+#include "carsettings.h"
+#include "latencyhistogram.h"
+#include "deviceworker.h"
 
 class DeviceInfo;
 
@@ -17,6 +31,20 @@ class DeviceHandler : public BluetoothBaseClass
     Q_OBJECT
     Q_PROPERTY(AddressType addressType READ addressType WRITE setAddressType)
     Q_PROPERTY(bool alive READ alive NOTIFY aliveChanged)
+    Q_PROPERTY(bool simulated READ simulated NOTIFY transportChanged)
+    Q_PROPERTY(bool binaryLivestats READ binaryLivestats NOTIFY livestatsFormatChanged)
+    Q_PROPERTY(int mtu READ mtu NOTIFY mtuChanged)
+    Q_PROPERTY(int livestatsRecordsDiscarded READ livestatsRecordsDiscarded NOTIFY livestatsRecordsDiscardedChanged)
+    Q_PROPERTY(bool livedataVisible READ livedataVisible WRITE setLivedataVisible NOTIFY livedataVisibleChanged)
+    Q_PROPERTY(QString connectionProfile READ connectionProfile NOTIFY connectionProfileChanged)
+    Q_PROPERTY(double connectionInterval READ connectionInterval NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int connectionLatency READ connectionLatency NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int supervisionTimeout READ supervisionTimeout NOTIFY connectionParametersChanged)
+    Q_PROPERTY(TelemetrySnapshot telemetry READ telemetry NOTIFY telemetryChanged)
+    Q_PROPERTY(DrivingMetrics metrics READ metrics NOTIFY telemetryChanged)
+    Q_PROPERTY(SessionRecorder* recorder READ recorder CONSTANT)
+    Q_PROPERTY(CarSettings* carSettings READ carSettings CONSTANT)
+    Q_PROPERTY(int historyCapacity READ historyCapacity WRITE setHistoryCapacity NOTIFY historyCapacityChanged)
     Q_PROPERTY(float frontVoltage READ frontVoltage NOTIFY frontVoltageChanged);
     Q_PROPERTY(float backVoltage READ backVoltage NOTIFY backVoltageChanged);
     Q_PROPERTY(float frontTemperature READ frontTemperature NOTIFY frontTemperatureChanged);
@@ -34,53 +62,205 @@ class DeviceHandler : public BluetoothBaseClass
     Q_PROPERTY(float backLeftDcLink READ backLeftDcLink NOTIFY backLeftDcLinkChanged);
     Q_PROPERTY(float backRightDcLink READ backRightDcLink NOTIFY backRightDcLinkChanged);
 
+    Q_PROPERTY(bool binaryRemoteControl READ binaryRemoteControl NOTIFY livestatsFormatChanged)
     Q_PROPERTY(bool remoteControlActive READ remoteControlActive WRITE setRemoteControlActive NOTIFY remoteControlActiveChanged);
+    Q_PROPERTY(int controlDeadband READ controlDeadband WRITE setControlDeadband NOTIFY controlSchedulerChanged)
+    Q_PROPERTY(int controlMaxRate READ controlMaxRate WRITE setControlMaxRate NOTIFY controlSchedulerChanged)
+    Q_PROPERTY(int controlKeepaliveInterval READ controlKeepaliveInterval WRITE setControlKeepaliveInterval NOTIFY controlSchedulerChanged)
+    Q_PROPERTY(ControlWriteMode controlWriteMode READ controlWriteMode WRITE setControlWriteMode NOTIFY controlWriteModeChanged)
+    Q_PROPERTY(bool unacknowledgedWriteSupported READ unacknowledgedWriteSupported NOTIFY controlWriteModeChanged)
+    Q_PROPERTY(int maxControlWritesInFlight READ maxControlWritesInFlight WRITE setMaxControlWritesInFlight NOTIFY maxControlWritesInFlightChanged)
+    Q_PROPERTY(int controlWritesInFlight READ controlWritesInFlight NOTIFY controlStatsChanged)
+    Q_PROPERTY(int controlFramesSent READ controlFramesSent NOTIFY controlStatsChanged)
+    Q_PROPERTY(int controlFramesSuperseded READ controlFramesSuperseded NOTIFY controlStatsChanged)
+    Q_PROPERTY(int controlFramesDropped READ controlFramesDropped NOTIFY controlStatsChanged)
+    Q_PROPERTY(LatencyStats controlRoundTrip READ controlRoundTrip NOTIFY latencyStatsChanged)
+    Q_PROPERTY(LatencyStats controlLatency READ controlLatency NOTIFY latencyStatsChanged)
+    Q_PROPERTY(LatencyStats livestatsInterval READ livestatsInterval NOTIFY latencyStatsChanged)
+    Q_PROPERTY(GattQueueStats gattQueue READ gattQueue NOTIFY gattQueueChanged)
+    Q_PROPERTY(bool tracing READ tracing WRITE setTracing NOTIFY tracingChanged)
     Q_PROPERTY(int remoteControlFrontLeft WRITE setRemoteControlFrontLeft);
     Q_PROPERTY(int remoteControlFrontRight WRITE setRemoteControlFrontRight);
     Q_PROPERTY(int remoteControlBackLeft WRITE setRemoteControlBackLeft);
     Q_PROPERTY(int remoteControlBackRight WRITE setRemoteControlBackRight);
 
 public:
+    // ms between two automatic trace dumps on errors
+    static constexpr int minTraceDumpInterval = 60000;
+
     enum class AddressType {
         PublicAddress,
         RandomAddress
     };
     Q_ENUM(AddressType)
 
+    enum class ControlWriteMode {
+        // every frame is confirmed by the car, at most maxControlWritesInFlight
+        // unconfirmed frames are outstanding at a time
+        AcknowledgedWrite,
+        // frames are handed to the stack with WriteWithoutResponse, falls back
+        // to AcknowledgedWrite when the characteristic does not support it
+        UnacknowledgedWrite
+    };
+    Q_ENUM(ControlWriteMode)
+
     DeviceHandler(QObject *parent = nullptr);
+    // one of several handlers sharing workerThread, which has to outlive
+    // them. Telemetry is only taken over by drainTelemetry(), whoever owns
+    // the thread calls it for all handlers at once, see FleetManager.
+    DeviceHandler(QThread &workerThread, int historyCapacity, QObject *parent = nullptr);
+    ~DeviceHandler() override;
 
     void setDevice(const QBluetoothDeviceInfo &device);
     void setAddressType(AddressType type);
     AddressType addressType() const;
 
-    bool alive() const;
-
-    float frontVoltage() const { return m_frontVoltage; }
-    float backVoltage() const { return m_backVoltage; }
-    float frontTemperature() const { return m_frontTemperature; }
-    float backTemperature() const { return m_backTemperature; }
-    int frontLeftError() const { return m_frontLeftError; }
-    int frontRightError() const { return m_frontRightError; }
-    int backLeftError() const { return m_backLeftError; }
-    int backRightError() const { return m_backRightError; }
-    float frontLeftSpeed() const { return m_frontLeftSpeed; }
-    float frontRightSpeed() const { return m_frontRightSpeed; }
-    float backLeftSpeed() const { return m_backLeftSpeed; }
-    float backRightSpeed() const { return m_backRightSpeed; }
-    float frontLeftDcLink() const { return m_frontLeftDcLink; }
-    float frontRightDcLink() const { return m_frontRightDcLink; }
-    float backLeftDcLink() const { return m_backLeftDcLink; }
-    float backRightDcLink() const { return m_backRightDcLink; }
-
-    bool remoteControlActive() const { return m_timerId != -1; }
+    bool alive() const { return m_alive; }
+
+    // takes ownership and moves the transport to the worker thread, the
+    // previous transport is disconnected and deleted
+    void setTransport(BobbycarTransport *transport);
+    bool simulated() const { return m_simulated; }
+
+    bool binaryLivestats() const { return m_binaryLivestats; }
+
+    // negotiated ATT MTU, a notification carries at most mtu() - 3 bytes
+    int mtu() const { return m_mtu; }
+    // fragmented livestats records dropped because of lost, reordered or
+    // timed out fragments
+    int livestatsRecordsDiscarded() const { return m_livestatsRecordsDiscarded; }
+
+    // set by pages showing telemetry. The connection profile follows
+    // automatically: lowLatency while remote control is active, balanced
+    // while telemetry is visible, lowPower otherwise
+    bool livedataVisible() const { return m_livedataVisible; }
+    void setLivedataVisible(bool livedataVisible);
+    // last requested profile
+    QString connectionProfile() const { return m_connectionProfile; }
+    // parameters granted by the stack, 0 until the first update
+    double connectionInterval() const { return m_connectionInterval; }
+    int connectionLatency() const { return m_connectionLatency; }
+    int supervisionTimeout() const { return m_supervisionTimeout; }
+
+    const TelemetrySnapshot &telemetry() const { return m_telemetry; }
+
+    // fed with every snapshot, including the ones bindings never see
+    const DrivingMetrics &metrics() const { return m_metrics; }
+    Q_INVOKABLE void resetTrip();
+
+    SessionRecorder *recorder() { return &m_recorder; }
+
+    // WifiListModel asks through here, see DeviceWorker::requestWifiList()
+    void requestWifiList(int scan);
+
+    // cleared for every setDevice(), a new car has unknown settings
+    CarSettings *carSettings() { return &m_carSettings; }
+
+    // feeds a livestats frame through the regular decoding and property path,
+    // used for replaying recorded sessions. timestamp in ms since the epoch,
+    // it ends up in the history and the driving metrics.
+    void injectLivestats(const QByteArray &value, qint64 timestamp);
+
+    const TelemetryHistory &history() const { return m_history; }
+    int historyCapacity() const { return m_history.capacity(); }
+    // drops the recorded history, meant to be set once at startup
+    void setHistoryCapacity(int historyCapacity);
+    Q_INVOKABLE void clearHistory() { m_history.clear(); }
+
+    // takes everything the worker decoded since the last call into the
+    // history and properties, false if there was nothing
+    bool drainTelemetry();
+
+    float frontVoltage() const { return m_telemetry.livestats().frontVoltage; }
+    float backVoltage() const { return m_telemetry.livestats().backVoltage; }
+    float frontTemperature() const { return m_telemetry.livestats().frontTemperature; }
+    float backTemperature() const { return m_telemetry.livestats().backTemperature; }
+    int frontLeftError() const { return m_telemetry.livestats().frontLeftError; }
+    int frontRightError() const { return m_telemetry.livestats().frontRightError; }
+    int backLeftError() const { return m_telemetry.livestats().backLeftError; }
+    int backRightError() const { return m_telemetry.livestats().backRightError; }
+    float frontLeftSpeed() const { return m_telemetry.livestats().frontLeftSpeed; }
+    float frontRightSpeed() const { return m_telemetry.livestats().frontRightSpeed; }
+    float backLeftSpeed() const { return m_telemetry.livestats().backLeftSpeed; }
+    float backRightSpeed() const { return m_telemetry.livestats().backRightSpeed; }
+    float frontLeftDcLink() const { return m_telemetry.livestats().frontLeftDcLink; }
+    float frontRightDcLink() const { return m_telemetry.livestats().frontRightDcLink; }
+    float backLeftDcLink() const { return m_telemetry.livestats().backLeftDcLink; }
+    float backRightDcLink() const { return m_telemetry.livestats().backRightDcLink; }
+
+    // firmware streaming binary livestats also understands binary control frames
+    bool binaryRemoteControl() const { return binaryLivestats(); }
+
+    bool remoteControlActive() const { return m_remoteControlActive; }
     void setRemoteControlActive(bool remoteControlActive);
-    void setRemoteControlFrontLeft(int remoteControlFrontLeft) { m_remoteControlFrontLeft = remoteControlFrontLeft; }
-    void setRemoteControlFrontRight(int remoteControlFrontRight) { m_remoteControlFrontRight = remoteControlFrontRight; }
-    void setRemoteControlBackLeft(int remoteControlBackLeft) { m_remoteControlBackLeft = remoteControlBackLeft; }
-    void setRemoteControlBackRight(int remoteControlBackRight) { m_remoteControlBackRight = remoteControlBackRight; }
+
+    // setpoint changes larger than this are sent right away, smaller ones
+    // only go out with the next keepalive
+    int controlDeadband() const { return m_controlSettings.deadband; }
+    void setControlDeadband(int controlDeadband);
+
+    // upper bound for control frames per second
+    int controlMaxRate() const { return m_controlSettings.maxRate; }
+    void setControlMaxRate(int controlMaxRate);
+
+    // milliseconds between frames while the setpoints do not change
+    int controlKeepaliveInterval() const { return m_controlSettings.keepaliveInterval; }
+    void setControlKeepaliveInterval(int controlKeepaliveInterval);
+    ControlWriteMode controlWriteMode() const { return m_controlWriteMode; }
+    void setControlWriteMode(ControlWriteMode controlWriteMode);
+    bool unacknowledgedWriteSupported() const { return m_unacknowledgedWriteSupported; }
+
+    int maxControlWritesInFlight() const { return m_controlSettings.maxWritesInFlight; }
+    void setMaxControlWritesInFlight(int maxControlWritesInFlight);
+
+    int controlWritesInFlight() const { return m_controlWritesInFlight; }
+    int controlFramesSent() const { return m_controlFramesSent; }
+    int controlFramesSuperseded() const { return m_controlFramesSuperseded; }
+    int controlFramesDropped() const { return m_controlFramesDropped; }
+
+    // acknowledged control write until its confirmation
+    LatencyStats controlRoundTrip() const { return m_controlRoundTrip; }
+    // first setpoint change carried by a frame until the frame is confirmed
+    LatencyStats controlLatency() const { return m_controlLatency; }
+    // time between two livestats notifications
+    LatencyStats livestatsInterval() const { return m_livestatsInterval; }
+
+    // depth, wait times per priority, superseded and timed out operations
+    // of the GATT operation queue
+    GattQueueStats gattQueue() const { return m_gattQueue; }
+
+    Q_INVOKABLE void resetLatencyStats();
+    // writes all histograms as text, defaults to a timestamped file in the
+    // app data location
+    Q_INVOKABLE bool dumpLatencyStats(const QString &fileName = {});
+
+    // records hot path events of all threads into the in-memory TraceRing
+    bool tracing() const;
+    void setTracing(bool tracing);
+    // writes the trace ring as text, defaults to a timestamped file in the
+    // app data location. Also done automatically on worker errors while
+    // tracing, at most once per minTraceDumpInterval.
+    Q_INVOKABLE bool dumpTrace(const QString &fileName = {});
+
+    // sets all four wheels at once, so no frame can mix old and new values
+    Q_INVOKABLE void setRemoteControl(int frontLeft, int frontRight, int backLeft, int backRight);
+
+    void setRemoteControlFrontLeft(int remoteControlFrontLeft) { m_remoteControl.frontLeft = remoteControlFrontLeft; publishSetpoints(); }
+    void setRemoteControlFrontRight(int remoteControlFrontRight) { m_remoteControl.frontRight = remoteControlFrontRight; publishSetpoints(); }
+    void setRemoteControlBackLeft(int remoteControlBackLeft) { m_remoteControl.backLeft = remoteControlBackLeft; publishSetpoints(); }
+    void setRemoteControlBackRight(int remoteControlBackRight) { m_remoteControl.backRight = remoteControlBackRight; publishSetpoints(); }
 
 signals:
     void aliveChanged();
+    void transportChanged();
+    void livestatsFormatChanged();
+    void mtuChanged();
+    void livestatsRecordsDiscardedChanged();
+    void livedataVisibleChanged();
+    void connectionProfileChanged();
+    void connectionParametersChanged();
+    void telemetryChanged();
+    void historyCapacityChanged();
 
     void frontVoltageChanged();
     void backVoltageChanged();
@@ -100,64 +280,83 @@ signals:
     void backRightDcLinkChanged();
 
     void remoteControlActiveChanged();
-
-protected:
-    void timerEvent(QTimerEvent *event) override;
+    void controlSchedulerChanged();
+    void controlWriteModeChanged();
+    void maxControlWritesInFlightChanged();
+    void controlStatsChanged();
+    void latencyStatsChanged();
+    void gattQueueChanged();
+    void tracingChanged();
+    void wifiListReceived(int scan, const QVector<WifiNetwork> &networks, bool last);
 
 public slots:
     void disconnectService();
+    void resetControlStats();
 
 private:
-    void disconnectInternal();
+    DeviceHandler(QThread *workerThread, int historyCapacity, QObject *parent);
 
-    //QLowEnergyController
-    void serviceDiscovered(const QBluetoothUuid &);
-    void serviceScanDone();
+    //DeviceWorker
+    void workerLinkChanged(bool alive, bool unacknowledgedWriteSupported);
+    void workerLivestatsFormatChanged(bool binary);
+    void workerMtuChanged(int mtu);
+    void workerLivestatsDiscardedChanged(int recordsDiscarded);
+    void workerConnectionProfileChanged(const QString &profile);
+    void workerConnectionParametersChanged(double interval, int latency, int supervisionTimeout);
+    void workerRemoteControlActiveChanged(bool remoteControlActive);
+    void workerControlStatsChanged(int writesInFlight, int framesSent, int framesSuperseded, int framesDropped);
+    void workerLatencyStatsChanged(const LatencyStats &controlRoundTrip, const LatencyStats &controlLatency, const LatencyStats &livestatsInterval);
+    void workerGattQueueStatsChanged(const GattQueueStats &stats);
+    void workerErrorOccurred(const QString &message);
 
-    //QLowEnergyService
-    void serviceStateChanged(QLowEnergyService::ServiceState s);
-    void updateBobbycarValue(const QLowEnergyCharacteristic &c,
-                             const QByteArray &value);
-    void confirmedDescriptorWrite(const QLowEnergyDescriptor &d,
-                                  const QByteArray &value);
-    void confirmedCharacteristicWrite(const QLowEnergyCharacteristic &info,
-                                      const QByteArray &value);
+    void publishSetpoints();
+    void applyTelemetry(const TelemetrySnapshot &telemetry);
+    void postControlSettings();
 
-    void sendRemoteControl();
+    // runs the functor on the worker thread
+    template<typename Functor>
+    void post(Functor &&functor) { QMetaObject::invokeMethod(m_worker, std::forward<Functor>(functor), Qt::QueuedConnection); }
 
 private:
     QLowEnergyController::RemoteAddressType m_addressType = QLowEnergyController::PublicAddress;
-    QLowEnergyController *m_control = nullptr;
-    QLowEnergyService *m_service = nullptr;
-    QLowEnergyDescriptor m_notificationDescLivestats;
-    QLowEnergyCharacteristic m_remotecontrolCharacteristic;
-    QBluetoothDeviceInfo m_currentDevice;
-
-    bool m_foundBobbycarService{};
-
-    float m_frontVoltage{};
-    float m_backVoltage{};
-    float m_frontTemperature{};
-    float m_backTemperature{};
-    uint8_t m_frontLeftError{};
-    uint8_t m_frontRightError{};
-    uint8_t m_backLeftError{};
-    uint8_t m_backRightError{};
-    float m_frontLeftSpeed{};
-    float m_frontRightSpeed{};
-    float m_backLeftSpeed{};
-    float m_backRightSpeed{};
-    float m_frontLeftDcLink{};
-    float m_frontRightDcLink{};
-    float m_backLeftDcLink{};
-    float m_backRightDcLink{};
-
-    int m_timerId{-1};
-
-    int m_remoteControlFrontLeft{};
-    int m_remoteControlFrontRight{};
-    int m_remoteControlBackLeft{};
-    int m_remoteControlBackRight{};
-
-    bool m_waitingForWrite{};
+
+    DeviceHandoff m_handoff;
+    // only started when no shared thread was passed in
+    QThread m_ownWorkerThread;
+    QThread *m_workerThread{};
+    DeviceWorker *m_worker{};
+
+    // state mirrored from the worker
+    bool m_alive{};
+    bool m_simulated{};
+    bool m_binaryLivestats{};
+    int m_mtu{defaultAttMtu};
+    int m_livestatsRecordsDiscarded{};
+    QString m_connectionProfile;
+    double m_connectionInterval{};
+    int m_connectionLatency{};
+    int m_supervisionTimeout{};
+    bool m_unacknowledgedWriteSupported{};
+    bool m_remoteControlActive{};
+    int m_controlWritesInFlight{};
+    int m_controlFramesSent{};
+    int m_controlFramesSuperseded{};
+    int m_controlFramesDropped{};
+    LatencyStats m_controlRoundTrip;
+    LatencyStats m_controlLatency;
+    LatencyStats m_livestatsInterval;
+    GattQueueStats m_gattQueue;
+
+    TelemetrySnapshot m_telemetry;
+    DrivingMetrics m_metrics;
+    TelemetryHistory m_history;
+    SessionRecorder m_recorder;
+    CarSettings m_carSettings;
+
+    bool m_livedataVisible{};
+    ControlWriteMode m_controlWriteMode{ControlWriteMode::AcknowledgedWrite};
+    ControlSettings m_controlSettings;
+    RemoteControlSetpoints m_remoteControl;
+
+    QElapsedTimer m_lastTraceDump;
 };
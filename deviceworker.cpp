@@ -0,0 +1,678 @@
+#include "deviceworker.h"
+
+// system includes
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+// Qt includes
+#include <QDateTime>
+#include <QDebug>
+
+// local includes
+#include "sessionrecorder.h"
+#include "settingsframe.h"
+#include "tracing.h"
+
+DeviceWorker::DeviceWorker(DeviceHandoff &handoff, SessionRecorder &recorder, QObject *parent) :
+    QObject{parent},
+    m_handoff{handoff},
+    m_recorder{recorder},
+    m_gatt{this},
+    m_controlTimer{this},
+    m_reassemblyTimer{this},
+    m_connectionProfileTimer{this},
+    m_statsTimer{this}
+{
+    m_reassemblyTimer.setSingleShot(true);
+    connect(&m_reassemblyTimer, &QTimer::timeout, this, &DeviceWorker::expireLivestatsFragments);
+
+    connect(&m_gatt, &GattScheduler::written, this, &DeviceWorker::confirmedCharacteristicWrite);
+    connect(&m_gatt, &GattScheduler::writeFailed, this, &DeviceWorker::characteristicWriteFailed);
+    connect(&m_gatt, &GattScheduler::statsChanged, this, &DeviceWorker::gattQueueStatsUpdated);
+
+    m_connectionProfileTimer.setSingleShot(true);
+    connect(&m_connectionProfileTimer, &QTimer::timeout, this, [this]() {
+        if (m_transport && m_transport->isReady())
+            requestConnectionProfile(wantedConnectionProfile());
+    });
+
+    for (QByteArray &frame : m_remoteControlFrames)
+        frame.reserve(remoteControlFrameCapacity);
+
+    m_controlTimer.setSingleShot(true);
+    m_controlTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_controlTimer, &QTimer::timeout, this, &DeviceWorker::controlTimerElapsed);
+
+    m_statsTimer.setSingleShot(true);
+    m_statsTimer.setInterval(statsPublishInterval);
+    connect(&m_statsTimer, &QTimer::timeout, this, &DeviceWorker::publishStats);
+}
+
+void DeviceWorker::setTransport(BobbycarTransport *transport)
+{
+    if (m_transport == transport || !transport)
+        return;
+
+    if (m_transport)
+    {
+        m_transport->disconnect(this);
+        m_transport->disconnectFromDevice();
+        m_transport->deleteLater();
+    }
+
+    m_transport = transport;
+    m_transport->setParent(this);
+
+    connect(m_transport, &BobbycarTransport::stateChanged, this, &DeviceWorker::transportStateChanged);
+    connect(m_transport, &BobbycarTransport::mtuChanged, this, &DeviceWorker::mtuChanged);
+    connect(m_transport, &BobbycarTransport::connectionParametersChanged, this, &DeviceWorker::connectionParametersUpdated);
+    connect(m_transport, &BobbycarTransport::infoMessage, this, &DeviceWorker::infoMessage);
+    connect(m_transport, &BobbycarTransport::errorOccurred, this, &DeviceWorker::errorOccurred);
+    connect(m_transport, &BobbycarTransport::characteristicChanged, this, &DeviceWorker::updateBobbycarValue);
+    m_gatt.setTransport(m_transport);
+
+    emit mtuChanged(m_transport->mtu());
+    transportStateChanged();
+}
+
+void DeviceWorker::connectToDevice(const QBluetoothDeviceInfo &device, QLowEnergyController::RemoteAddressType addressType)
+{
+    m_transport->setRemoteAddressType(addressType);
+    m_transport->connectToDevice(device);
+}
+
+void DeviceWorker::disconnectFromDevice()
+{
+    m_transport->disconnectFromDevice();
+}
+
+void DeviceWorker::setControlSettings(const ControlSettings &settings)
+{
+    m_settings = settings;
+    m_gatt.setMaxInFlight(m_settings.maxWritesInFlight);
+    scheduleRemoteControl();
+}
+
+void DeviceWorker::setRemoteControlActive(bool remoteControlActive)
+{
+    if (!remoteControlActive && m_remoteControlActive)
+    {
+        m_controlTimer.stop();
+        setRemoteControlActiveState(false);
+
+        if (remoteControlAvailable())
+        {
+            m_remoteControl = {};
+
+            sendRemoteControl();
+        }
+    }
+    else if (remoteControlActive && !m_remoteControlActive && remoteControlAvailable())
+    {
+        setRemoteControlActiveState(true);
+
+        sendRemoteControl();
+    }
+    else
+    {
+        // let the GUI side drop a request that could not be honoured
+        emit remoteControlActiveChanged(m_remoteControlActive);
+    }
+}
+
+void DeviceWorker::resetControlStats()
+{
+    m_controlFramesSent = 0;
+    m_controlFramesSuperseded = 0;
+    m_controlFramesDropped = 0;
+    publishControlStats();
+}
+
+void DeviceWorker::setLivedataVisible(bool livedataVisible)
+{
+    if (m_livedataVisible == livedataVisible)
+        return;
+
+    m_livedataVisible = livedataVisible;
+    updateConnectionProfile();
+}
+
+void DeviceWorker::applySettings(int transaction, const QVariantMap &changes)
+{
+    if (m_settingsTransaction >= 0)
+    {
+        qWarning() << "settings transaction" << m_settingsTransaction << "still running";
+        emit settingsApplied(transaction, false);
+        return;
+    }
+
+    if (!m_transport || !m_transport->isReady() || !m_transport->hasCharacteristic(settingsSetterUuid))
+    {
+        emit errorOccurred("settingsSetterUuid not found.");
+        emit settingsApplied(transaction, false);
+        return;
+    }
+
+    QVector<QByteArray> chunks;
+    const int chunkSize = std::max(m_transport->mtu() - attWriteOverhead, minSettingsChunkSize);
+    if (!encodeSettingsTransaction(changes, uint8_t(transaction), chunkSize, chunks) || chunks.isEmpty())
+    {
+        emit errorOccurred("Settings could not be packed into writes.");
+        emit settingsApplied(transaction, false);
+        return;
+    }
+
+    m_settingsTransaction = transaction;
+    m_settingsWritesPending = chunks.size();
+    m_settingsWriteFailed = false;
+
+    for (const QByteArray &chunk : qAsConst(chunks))
+        m_gatt.write(GattPriority::Settings, settingsSetterUuid, chunk);
+}
+
+void DeviceWorker::requestWifiList(int scan)
+{
+    if (!m_transport || !m_transport->isReady() || !m_transport->hasCharacteristic(wifiListUuid))
+    {
+        emit errorOccurred("wifiListUuid not found.");
+        emit wifiListReceived(scan, {}, true);
+        return;
+    }
+
+    // queued in order, the subscription is in place before the car answers
+    if (!m_wifiListNotifications)
+    {
+        m_gatt.setNotificationsEnabled(wifiListUuid, true);
+        m_wifiListNotifications = true;
+    }
+
+    m_gatt.write(GattPriority::Background, wifiListUuid, encodeWifiListRequest(scan));
+}
+
+void DeviceWorker::takeSetpoints()
+{
+    m_handoff.setpointsWakeup.store(false);
+
+    TimedSetpoints setpoints;
+    if (!m_handoff.setpoints.take(setpoints))
+        return;
+
+    m_remoteControl = setpoints.setpoints;
+    m_latestInputTime = setpoints.inputTime;
+    scheduleRemoteControl();
+}
+
+void DeviceWorker::injectLivestats(const QByteArray &value, qint64 timestamp)
+{
+    handleLivestats(value, timestamp);
+}
+
+void DeviceWorker::resetLatencyStats()
+{
+    m_latency.controlRoundTrip.reset();
+    m_latency.controlLatency.reset();
+    m_latency.livestatsInterval.reset();
+    publishLatencyStats();
+
+    m_gatt.resetStats();
+}
+
+void DeviceWorker::transportStateChanged()
+{
+    // whatever was queued belongs to the previous link
+    m_gatt.clear();
+
+    if (m_settingsTransaction >= 0)
+    {
+        emit settingsApplied(m_settingsTransaction, false);
+        m_settingsTransaction = -1;
+    }
+
+    m_wifiListNotifications = false;
+
+    m_controlTimer.stop();
+    if (m_remoteControlActive)
+        setRemoteControlActiveState(false);
+
+    m_controlWritesInFlight = 0;
+    setControlFramePending(false);
+
+    m_controlWriteTimings.clear();
+    m_pendingInputTime = -1;
+    m_lastLivestatsNotification = -1;
+
+    m_reassembler.reset();
+    m_reassemblyTimer.stop();
+
+    m_connectionProfileRequested = false;
+    m_connectionProfileTimer.stop();
+
+    if (m_transport->isReady())
+    {
+        if (m_transport->hasCharacteristic(livestatsCharacUuid))
+            m_gatt.setNotificationsEnabled(livestatsCharacUuid, true);
+        else
+            emit errorOccurred("livestatsCharacUuid not found.");
+
+        if (!m_transport->hasCharacteristic(remotecontrolCharacUuid))
+            emit errorOccurred("remotecontrolCharacUuid not found.");
+
+        updateConnectionProfile();
+    }
+    else
+        emit connectionParametersChanged(0., 0, 0);
+
+    emit linkChanged(m_transport->isReady(), m_transport->supportsWriteWithoutResponse(remotecontrolCharacUuid));
+    publishControlStats();
+}
+
+void DeviceWorker::updateBobbycarValue(const QBluetoothUuid &uuid, const QByteArray &value)
+{
+    if (uuid == livestatsCharacUuid)
+    {
+        const qint64 timestamp = now();
+        BOBBYCAR_TRACE(lcTelemetry, TraceEvent::LivestatsReceived, value.size(),
+                       m_lastLivestatsNotification >= 0 ? timestamp - m_lastLivestatsNotification : -1);
+        if (m_lastLivestatsNotification >= 0)
+        {
+            m_latency.livestatsInterval.record(timestamp - m_lastLivestatsNotification);
+            latencyStatsUpdated();
+        }
+        m_lastLivestatsNotification = timestamp;
+
+        m_recorder.record(SessionRecordType::Livestats, value);
+        handleLivestats(value, QDateTime::currentMSecsSinceEpoch());
+    }
+    else if (uuid == wifiListUuid)
+    {
+        QString errorString;
+        if (parseWifiListChunk(value, m_wifiListChunk, errorString))
+            emit wifiListReceived(m_wifiListChunk.scan, m_wifiListChunk.networks, m_wifiListChunk.last);
+        else
+            qWarning() << "could not parse wifi list chunk" << errorString;
+    }
+    else
+        qWarning() << "unknown uuid" << uuid;
+}
+
+void DeviceWorker::handleLivestats(const QByteArray &value, qint64 timestamp)
+{
+    const LivestatsFormat format = detectLivestatsFormat(value);
+
+    Livestats livestats;
+    QString errorString;
+    bool parsed{};
+    switch (format)
+    {
+    case LivestatsFormat::BinaryV1:
+        parsed = parseLivestatsBinary(value, livestats, errorString);
+        break;
+    case LivestatsFormat::Json:
+        parsed = parseLivestatsJson(value, livestats, errorString);
+        break;
+    case LivestatsFormat::Fragment:
+        handleLivestatsFragment(value, timestamp);
+        return;
+    default:
+        errorString = QStringLiteral("unknown livestats format");
+    }
+
+    if (!parsed)
+    {
+        qWarning() << "could not parse livestats" << errorString;
+        if (m_transport && value.size() >= m_transport->mtu() - attNotificationOverhead)
+            qWarning() << "livestats filled a whole notification at MTU" << m_transport->mtu()
+                       << "and were probably cut off, the firmware has to fragment them";
+        return;
+    }
+
+    if (m_livestatsFormat != format)
+    {
+        m_livestatsFormat = format;
+        emit livestatsFormatChanged(m_livestatsFormat == LivestatsFormat::BinaryV1);
+    }
+
+    if (!m_handoff.telemetry.push(TelemetrySnapshot{livestats, timestamp}))
+    {
+        // the GUI thread is stalled, it will catch up with the newer frames
+        if (!m_telemetryOverruns++)
+            qWarning() << "telemetry handoff full, dropping snapshots";
+        return;
+    }
+
+    m_telemetryOverruns = 0;
+    if (!m_handoff.telemetryWakeup.exchange(true))
+        emit telemetryAvailable();
+}
+
+void DeviceWorker::handleLivestatsFragment(const QByteArray &value, qint64 timestamp)
+{
+    switch (m_reassembler.append(value, m_handoff.clock.elapsed()))
+    {
+    case LivestatsReassembler::Result::Incomplete:
+        if (!m_reassemblyTimer.isActive())
+            m_reassemblyTimer.start(m_reassembler.timeout());
+        break;
+    case LivestatsReassembler::Result::Complete:
+        m_reassemblyTimer.stop();
+        if (detectLivestatsFormat(m_reassembler.record()) == LivestatsFormat::Fragment)
+            qWarning() << "nested livestats fragments";
+        else
+            handleLivestats(m_reassembler.record(), timestamp);
+        break;
+    case LivestatsReassembler::Result::Discarded:
+        emit livestatsDiscardedChanged(m_reassembler.discarded());
+        if (m_reassembler.pending() && !m_reassemblyTimer.isActive())
+            m_reassemblyTimer.start(m_reassembler.timeout());
+        break;
+    }
+}
+
+void DeviceWorker::expireLivestatsFragments()
+{
+    if (m_reassembler.expire(m_handoff.clock.elapsed()))
+        emit livestatsDiscardedChanged(m_reassembler.discarded());
+    else if (m_reassembler.pending())
+        m_reassemblyTimer.start(m_reassembler.timeout());
+}
+
+void DeviceWorker::confirmedCharacteristicWrite(const QBluetoothUuid &uuid, const QByteArray &value)
+{
+    Q_UNUSED(value)
+
+    if (uuid == remotecontrolCharacUuid)
+    {
+        if (m_controlWritesInFlight > 0)
+            m_controlWritesInFlight--;
+
+        // confirmations arrive in write order
+        if (!m_controlWriteTimings.empty())
+        {
+            const qint64 timestamp = now();
+            const ControlWriteTiming timing = m_controlWriteTimings.front();
+            m_controlWriteTimings.pop_front();
+
+            m_latency.controlRoundTrip.record(timestamp - timing.written);
+            BOBBYCAR_TRACE(lcControl, TraceEvent::ControlAck, timestamp - timing.written, m_controlWritesInFlight);
+            if (timing.input >= 0)
+                m_latency.controlLatency.record(timestamp - timing.input);
+            latencyStatsUpdated();
+        }
+
+        if (m_controlFramePending && m_remoteControlActive)
+            sendRemoteControl();
+        else
+            publishControlStats();
+    }
+    else if (uuid == settingsSetterUuid)
+        settingsWriteFinished(true);
+}
+
+void DeviceWorker::characteristicWriteFailed(const QBluetoothUuid &uuid)
+{
+    if (uuid == remotecontrolCharacUuid && m_controlWritesInFlight > 0)
+    {
+        m_controlWritesInFlight--;
+        m_controlFramesDropped++;
+        BOBBYCAR_TRACE(lcControl, TraceEvent::ControlWriteFailed, m_controlWritesInFlight, m_controlFramesDropped);
+
+        if (!m_controlWriteTimings.empty())
+            m_controlWriteTimings.pop_front();
+
+        if (m_controlFramePending && m_remoteControlActive)
+            sendRemoteControl();
+        else
+            publishControlStats();
+    }
+    else if (uuid == settingsSetterUuid)
+        settingsWriteFinished(false);
+}
+
+void DeviceWorker::settingsWriteFinished(bool success)
+{
+    if (m_settingsTransaction < 0)
+        return;
+
+    m_settingsWriteFailed |= !success;
+    if (--m_settingsWritesPending > 0)
+        return;
+
+    // all chunks are through, the car only applies a complete transaction
+    const int transaction = m_settingsTransaction;
+    m_settingsTransaction = -1;
+    emit settingsApplied(transaction, !m_settingsWriteFailed);
+}
+
+bool DeviceWorker::remoteControlAvailable() const
+{
+    return m_transport && m_transport->isReady() && m_transport->hasCharacteristic(remotecontrolCharacUuid);
+}
+
+bool DeviceWorker::useUnacknowledgedWrite() const
+{
+    if (!m_settings.unacknowledgedWrite || !m_transport->supportsWriteWithoutResponse(remotecontrolCharacUuid))
+        return false;
+
+    // a write without response is never split into a long write, a frame
+    // that might not fit into one packet at the negotiated MTU (20 bytes at
+    // the default one) goes out acknowledged instead. Judged by the longest
+    // frame of the format, so every frame of a link takes the same path.
+    const int maxFrameSize = m_livestatsFormat == LivestatsFormat::BinaryV1 ? remoteControlBinaryV1Size : remoteControlJsonMaxSize;
+    return maxFrameSize <= m_transport->mtu() - attWriteOverhead;
+}
+
+void DeviceWorker::scheduleRemoteControl()
+{
+    if (!m_remoteControlActive)
+        return;
+
+    const auto exceedsDeadband = [this](int value, int lastSent) {
+        return std::abs(value - lastSent) > m_settings.deadband;
+    };
+
+    const bool changed = exceedsDeadband(m_remoteControl.frontLeft, m_lastSentRemoteControl.frontLeft) ||
+                         exceedsDeadband(m_remoteControl.frontRight, m_lastSentRemoteControl.frontRight) ||
+                         exceedsDeadband(m_remoteControl.backLeft, m_lastSentRemoteControl.backLeft) ||
+                         exceedsDeadband(m_remoteControl.backRight, m_lastSentRemoteControl.backRight);
+
+    // the frame carrying this change is measured from its first input
+    if (changed && m_pendingInputTime < 0)
+        m_pendingInputTime = m_latestInputTime >= 0 ? m_latestInputTime : now();
+
+    const qint64 elapsed = m_lastControlSend.isValid() ? m_lastControlSend.elapsed() : std::numeric_limits<qint64>::max();
+    const qint64 interval = changed ? (1000 / m_settings.maxRate) : m_settings.keepaliveInterval;
+    const int delay = elapsed >= interval ? 0 : int(interval - elapsed);
+
+    // never postpone an earlier send that is already scheduled
+    if (m_controlTimer.isActive() && m_controlTimer.remainingTime() <= delay)
+        return;
+
+    m_controlTimer.start(delay);
+}
+
+void DeviceWorker::controlTimerElapsed()
+{
+    if (!m_remoteControlActive)
+        return;
+
+    if (!remoteControlAvailable())
+    {
+        setRemoteControlActiveState(false);
+        return;
+    }
+
+    if (useUnacknowledgedWrite() || m_controlWritesInFlight < m_settings.maxWritesInFlight)
+        sendRemoteControl();
+    else
+    {
+        // window is full, send the newest setpoints as soon as a write is confirmed
+        if (m_controlFramePending)
+            m_controlFramesSuperseded++;
+        setControlFramePending(true);
+        publishControlStats();
+    }
+}
+
+void DeviceWorker::sendRemoteControl()
+{
+    QByteArray &frame = nextRemoteControlFrame();
+    if (m_livestatsFormat == LivestatsFormat::BinaryV1)
+        encodeRemoteControlBinary(frame, m_remoteControlSequence++, m_remoteControl);
+    else
+        encodeRemoteControlJson(frame, m_remoteControl);
+
+    const qint64 inputTime = m_pendingInputTime;
+    m_pendingInputTime = -1;
+
+    if (useUnacknowledgedWrite())
+    {
+        // no confirmation will ever arrive for these, nothing is tracked as in
+        // flight and a frame still queued behind other traffic is outdated
+        m_gatt.write(GattPriority::Control, remotecontrolCharacUuid, frame, false, true);
+    }
+    else
+    {
+        m_controlWriteTimings.push_back({now(), inputTime});
+        m_gatt.write(GattPriority::Control, remotecontrolCharacUuid, frame);
+        m_controlWritesInFlight++;
+    }
+
+    // only now, lower classes must not get ahead of this frame
+    setControlFramePending(false);
+
+    m_recorder.record(SessionRecordType::RemoteControl, frame);
+
+    m_lastSentRemoteControl = m_remoteControl;
+    m_lastControlSend.start();
+
+    m_controlFramesSent++;
+    BOBBYCAR_TRACE(lcControl, TraceEvent::ControlWrite, m_controlFramesSent, m_controlWritesInFlight);
+    publishControlStats();
+
+    // arms the keepalive, or the next send if the setpoints moved meanwhile
+    scheduleRemoteControl();
+}
+
+void DeviceWorker::setControlFramePending(bool controlFramePending)
+{
+    m_controlFramePending = controlFramePending;
+    m_gatt.setControlPending(controlFramePending);
+}
+
+QByteArray &DeviceWorker::nextRemoteControlFrame()
+{
+    // skips buffers still referenced, if all of them are the encoder
+    // detaches (and allocates) once
+    for (int i = 0; i < remoteControlFrameBuffers; i++)
+    {
+        m_remoteControlFrameIndex = (m_remoteControlFrameIndex + 1) % remoteControlFrameBuffers;
+        if (m_remoteControlFrames[m_remoteControlFrameIndex].isDetached())
+            break;
+    }
+
+    return m_remoteControlFrames[m_remoteControlFrameIndex];
+}
+
+void DeviceWorker::setRemoteControlActiveState(bool remoteControlActive)
+{
+    m_remoteControlActive = remoteControlActive;
+    emit remoteControlActiveChanged(m_remoteControlActive);
+
+    updateConnectionProfile();
+}
+
+ConnectionProfile DeviceWorker::wantedConnectionProfile() const
+{
+    if (m_remoteControlActive)
+        return ConnectionProfile::LowLatency;
+    if (m_livedataVisible)
+        return ConnectionProfile::Balanced;
+    return ConnectionProfile::LowPower;
+}
+
+void DeviceWorker::updateConnectionProfile()
+{
+    if (!m_transport || !m_transport->isReady())
+        return;
+
+    // faster parameters are requested right away, slower ones only once they
+    // stayed wanted for a while, so short pauses in driving or switching
+    // pages do not renegotiate the link every time
+    const ConnectionProfile profile = wantedConnectionProfile();
+    if (m_connectionProfileRequested && profile < m_connectionProfile)
+    {
+        if (!m_connectionProfileTimer.isActive())
+            m_connectionProfileTimer.start(connectionProfileDowngradeDelay);
+        return;
+    }
+
+    m_connectionProfileTimer.stop();
+    requestConnectionProfile(profile);
+}
+
+void DeviceWorker::requestConnectionProfile(ConnectionProfile profile)
+{
+    if (m_connectionProfileRequested && profile == m_connectionProfile)
+        return;
+
+    // the link may be ready before the controller takes parameter updates,
+    // asked again until it does
+    if (!m_transport->requestConnectionParameters(connectionParameters(profile)))
+    {
+        m_connectionProfileTimer.start(connectionProfileRetryDelay);
+        return;
+    }
+
+    m_connectionProfile = profile;
+    m_connectionProfileRequested = true;
+    emit connectionProfileChanged(connectionProfileName(profile));
+}
+
+void DeviceWorker::connectionParametersUpdated(const QLowEnergyConnectionParameters &parameters)
+{
+    // the granted interval is reported as a range with both ends equal
+    emit connectionParametersChanged(parameters.maximumInterval(), parameters.latency(), parameters.supervisionTimeout());
+}
+
+void DeviceWorker::publishControlStats()
+{
+    emit controlStatsChanged(m_controlWritesInFlight, m_controlFramesSent, m_controlFramesSuperseded, m_controlFramesDropped);
+}
+
+void DeviceWorker::publishGattQueueStats()
+{
+    m_gattQueueStatsDirty = false;
+    emit gattQueueStatsChanged(m_gatt.stats());
+}
+
+void DeviceWorker::latencyStatsUpdated()
+{
+    m_latencyStatsDirty = true;
+    if (!m_statsTimer.isActive())
+        m_statsTimer.start();
+}
+
+void DeviceWorker::gattQueueStatsUpdated()
+{
+    m_gattQueueStatsDirty = true;
+    if (!m_statsTimer.isActive())
+        m_statsTimer.start();
+}
+
+void DeviceWorker::publishStats()
+{
+    if (m_latencyStatsDirty)
+        publishLatencyStats();
+    if (m_gattQueueStatsDirty)
+        publishGattQueueStats();
+}
+
+void DeviceWorker::publishLatencyStats()
+{
+    m_latencyStatsDirty = false;
+
+    emit latencyStatsChanged(LatencyStats{m_latency.controlRoundTrip},
+                             LatencyStats{m_latency.controlLatency},
+                             LatencyStats{m_latency.livestatsInterval});
+}
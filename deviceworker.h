@@ -0,0 +1,240 @@
+#pragma once
+
+// system includes
+#include <array>
+#include <atomic>
+#include <deque>
+
+// Qt includes
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QBluetoothDeviceInfo>
+#include <QLowEnergyController>
+
+// local includes
+#include "bobbycartransport.h"
+#include "connectionprofile.h"
+#include "gattscheduler.h"
+#include "wifilist.h"
+#include "livestats.h"
+#include "remotecontrolframe.h"
+#include "telemetrysnapshot.h"
+#include "latencyhistogram.h"
+#include "livestatsreassembler.h"
+#include "spscqueue.h"
+
+// forward declares
+class SessionRecorder;
+
+struct TimedSetpoints
+{
+    RemoteControlSetpoints setpoints;
+    // µs of DeviceHandoff::clock when the setpoints were set, -1 if unknown
+    qint64 inputTime{-1};
+};
+
+// Lock-free state shared between DeviceHandler on the GUI thread and its
+// DeviceWorker. Whoever fills a handoff raises the matching wakeup flag and
+// only posts an event to the other thread if the flag was not raised yet, the
+// receiver lowers it before draining.
+struct DeviceHandoff
+{
+    // started once before the worker, read from both threads
+    QElapsedTimer clock;
+
+    // worker -> GUI, every decoded livestats frame
+    SpscQueue<TelemetrySnapshot, 256> telemetry;
+    std::atomic<bool> telemetryWakeup{};
+
+    // GUI -> worker, only the newest setpoints matter
+    SpscLatest<TimedSetpoints> setpoints;
+    std::atomic<bool> setpointsWakeup{};
+};
+
+struct ControlSettings
+{
+    int deadband{5};
+    int maxRate{20};
+    int keepaliveInterval{500};
+    bool unacknowledgedWrite{};
+    int maxWritesInFlight{1};
+};
+
+struct LatencyHistograms
+{
+    LatencyHistogram controlRoundTrip;
+    LatencyHistogram controlLatency;
+    LatencyHistogram livestatsInterval;
+};
+
+// Owns the transport, decodes livestats and schedules control frames on the
+// DeviceHandler worker thread, so a busy GUI thread cannot delay either.
+// All methods have to be called on the worker thread, DeviceHandler posts
+// them there.
+class DeviceWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // ms a slower connection profile has to stay wanted before it is requested
+    static constexpr int connectionProfileDowngradeDelay = 2000;
+    // ms until a connection profile the transport could not take yet is
+    // requested again
+    static constexpr int connectionProfileRetryDelay = 500;
+    // settings chunks are never made smaller, below this the stack sends
+    // them as long writes
+    static constexpr int minSettingsChunkSize = 128;
+    // control frames are encoded into these in turn, more than can be queued
+    // and in flight at a time, so encoding never detaches a buffer the
+    // scheduler or the Bluetooth stack still holds
+    static constexpr int remoteControlFrameBuffers = 8;
+    // ms between latency and GATT queue statistics updates, they change with
+    // every packet but nobody reads them that often
+    static constexpr int statsPublishInterval = 333;
+
+    DeviceWorker(DeviceHandoff &handoff, SessionRecorder &recorder, QObject *parent = nullptr);
+
+    // takes ownership, the transport has to live in the worker thread already
+    void setTransport(BobbycarTransport *transport);
+    void connectToDevice(const QBluetoothDeviceInfo &device, QLowEnergyController::RemoteAddressType addressType);
+    void disconnectFromDevice();
+
+    void setControlSettings(const ControlSettings &settings);
+    void setRemoteControlActive(bool remoteControlActive);
+    void resetControlStats();
+    // telemetry is on screen, selects the balanced connection profile
+    void setLivedataVisible(bool livedataVisible);
+    // takes the newest setpoints from the handoff
+    void takeSetpoints();
+
+    // writes the changes as one settings transaction, ends in settingsApplied()
+    void applySettings(int transaction, const QVariantMap &changes);
+
+    // asks the car for its WiFi scan list, the chunks arrive through
+    // wifiListReceived()
+    void requestWifiList(int scan);
+
+    // decodes without recording, used for replaying recorded sessions,
+    // timestamp in ms since the epoch like live snapshots
+    void injectLivestats(const QByteArray &value, qint64 timestamp);
+
+    const LatencyHistograms &latencyHistograms() const { return m_latency; }
+    void resetLatencyStats();
+
+signals:
+    void infoMessage(const QString &message);
+    void errorOccurred(const QString &message);
+    void linkChanged(bool alive, bool unacknowledgedWriteSupported);
+    void livestatsFormatChanged(bool binary);
+    void telemetryAvailable();
+    void remoteControlActiveChanged(bool remoteControlActive);
+    void controlStatsChanged(int writesInFlight, int framesSent, int framesSuperseded, int framesDropped);
+    void mtuChanged(int mtu);
+    void connectionProfileChanged(const QString &profile);
+    // granted interval in ms, peripheral latency in intervals, supervision timeout in ms
+    void connectionParametersChanged(double interval, int latency, int supervisionTimeout);
+    void livestatsDiscardedChanged(int recordsDiscarded);
+    void latencyStatsChanged(const LatencyStats &controlRoundTrip, const LatencyStats &controlLatency, const LatencyStats &livestatsInterval);
+    void gattQueueStatsChanged(const GattQueueStats &stats);
+    void settingsApplied(int transaction, bool success);
+    void wifiListReceived(int scan, const QVector<WifiNetwork> &networks, bool last);
+
+private:
+    //BobbycarTransport
+    void transportStateChanged();
+    void updateBobbycarValue(const QBluetoothUuid &uuid,
+                             const QByteArray &value);
+    // timestamp of the notification in ms since the epoch
+    void handleLivestats(const QByteArray &value, qint64 timestamp);
+    void handleLivestatsFragment(const QByteArray &value, qint64 timestamp);
+    void expireLivestatsFragments();
+    void confirmedCharacteristicWrite(const QBluetoothUuid &uuid,
+                                      const QByteArray &value);
+    void characteristicWriteFailed(const QBluetoothUuid &uuid);
+    void settingsWriteFinished(bool success);
+    void connectionParametersUpdated(const QLowEnergyConnectionParameters &parameters);
+
+    ConnectionProfile wantedConnectionProfile() const;
+    void updateConnectionProfile();
+    void requestConnectionProfile(ConnectionProfile profile);
+
+    bool remoteControlAvailable() const;
+    bool useUnacknowledgedWrite() const;
+    void scheduleRemoteControl();
+    void controlTimerElapsed();
+    void sendRemoteControl();
+    QByteArray &nextRemoteControlFrame();
+    void setControlFramePending(bool controlFramePending);
+
+    void setRemoteControlActiveState(bool remoteControlActive);
+    void publishControlStats();
+    // publish with the next m_statsTimer tick
+    void latencyStatsUpdated();
+    void gattQueueStatsUpdated();
+    void publishStats();
+    void publishLatencyStats();
+    void publishGattQueueStats();
+
+    qint64 now() const { return m_handoff.clock.nsecsElapsed() / 1000; }
+
+    DeviceHandoff &m_handoff;
+    SessionRecorder &m_recorder;
+    BobbycarTransport *m_transport{};
+    // every GATT operation goes through here, never to m_transport directly
+    GattScheduler m_gatt;
+
+    LivestatsFormat m_livestatsFormat{LivestatsFormat::Unknown};
+    int m_telemetryOverruns{};
+
+    LivestatsReassembler m_reassembler;
+    QTimer m_reassemblyTimer;
+
+    bool m_livedataVisible{};
+    // reset on every state change, the new link starts with the OS defaults
+    bool m_connectionProfileRequested{};
+    ConnectionProfile m_connectionProfile{ConnectionProfile::LowPower};
+    QTimer m_connectionProfileTimer;
+
+    // -1 while no settings transaction is being written
+    int m_settingsTransaction{-1};
+    int m_settingsWritesPending{};
+    bool m_settingsWriteFailed{};
+
+    bool m_wifiListNotifications{};
+    WifiListChunk m_wifiListChunk;
+
+    ControlSettings m_settings;
+    bool m_remoteControlActive{};
+    QTimer m_controlTimer;
+    QElapsedTimer m_lastControlSend;
+
+    RemoteControlSetpoints m_remoteControl;
+    RemoteControlSetpoints m_lastSentRemoteControl;
+    uint8_t m_remoteControlSequence{};
+    std::array<QByteArray, remoteControlFrameBuffers> m_remoteControlFrames;
+    int m_remoteControlFrameIndex{};
+
+    int m_controlWritesInFlight{};
+    bool m_controlFramePending{};
+
+    int m_controlFramesSent{};
+    int m_controlFramesSuperseded{};
+    int m_controlFramesDropped{};
+
+    struct ControlWriteTiming
+    {
+        qint64 written;
+        qint64 input;
+    };
+
+    // all timestamps in µs of DeviceHandoff::clock, -1 if unset
+    std::deque<ControlWriteTiming> m_controlWriteTimings;
+    qint64 m_latestInputTime{-1};
+    qint64 m_pendingInputTime{-1};
+    qint64 m_lastLivestatsNotification{-1};
+    LatencyHistograms m_latency;
+    bool m_latencyStatsDirty{};
+    bool m_gattQueueStatsDirty{};
+    QTimer m_statsTimer;
+};
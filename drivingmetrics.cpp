@@ -0,0 +1,55 @@
+#include "drivingmetrics.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+
+// local includes
+#include "telemetrysnapshot.h"
+
+void DrivingMetrics::update(const TelemetrySnapshot &telemetry)
+{
+    const float previousSpeed = m_avgSpeed;
+    const float previousPower = m_totalPower;
+
+    m_avgSpeed = (telemetry.frontLeftSpeed() + telemetry.frontRightSpeed() + telemetry.backLeftSpeed() + telemetry.backRightSpeed()) / 4;
+    m_avgVoltage = (telemetry.frontVoltage() + telemetry.backVoltage()) / 2;
+    m_totalCurrent = telemetry.frontLeftDcLink() + telemetry.frontRightDcLink() + telemetry.backLeftDcLink() + telemetry.backRightDcLink();
+    m_totalPower = m_totalCurrent * m_avgVoltage;
+
+    m_peakPower = std::max(m_peakPower, m_totalPower);
+
+    const qint64 dt = telemetry.timestamp() - m_lastTimestamp;
+    const bool integrate = m_lastTimestamp >= 0 && dt > 0 && dt <= maxIntegrationGap;
+    m_lastTimestamp = telemetry.timestamp();
+    if (!integrate)
+        return;
+
+    // trapezoidal rule between the previous and the current snapshot
+    const double hours = dt / 3600000.;
+    m_tripTime += dt / 1000.;
+    m_tripDistance += std::abs(previousSpeed + m_avgSpeed) / 2 * hours;
+
+    const double energy = double(previousPower + m_totalPower) / 2 * hours;
+    if (energy >= 0)
+        m_energyConsumed += energy;
+    else
+        m_energyRegenerated -= energy;
+}
+
+void DrivingMetrics::resetTrip()
+{
+    m_tripDistance = 0;
+    m_tripTime = 0;
+    m_energyConsumed = 0;
+    m_energyRegenerated = 0;
+    m_peakPower = std::max(0.f, m_totalPower);
+}
+
+double DrivingMetrics::energyPerKm() const
+{
+    if (m_tripDistance < minEnergyPerKmDistance)
+        return 0;
+
+    return (m_energyConsumed - m_energyRegenerated) / m_tripDistance;
+}
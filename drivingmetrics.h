@@ -0,0 +1,75 @@
+#pragma once
+
+// Qt includes
+#include <QMetaType>
+#include <QtGlobal>
+
+// forward declares
+class TelemetrySnapshot;
+
+// Aggregates over the four wheels plus trip totals integrated over time,
+// updated incrementally with every telemetry snapshot. Handed to QML as a
+// single value like TelemetrySnapshot.
+class DrivingMetrics
+{
+    Q_GADGET
+    Q_PROPERTY(float avgSpeed READ avgSpeed)
+    Q_PROPERTY(float avgVoltage READ avgVoltage)
+    Q_PROPERTY(float totalCurrent READ totalCurrent)
+    Q_PROPERTY(float totalPower READ totalPower)
+    Q_PROPERTY(double tripDistance READ tripDistance)
+    Q_PROPERTY(double tripTime READ tripTime)
+    Q_PROPERTY(double energyConsumed READ energyConsumed)
+    Q_PROPERTY(double energyRegenerated READ energyRegenerated)
+    Q_PROPERTY(double energyPerKm READ energyPerKm)
+    Q_PROPERTY(float peakPower READ peakPower)
+
+public:
+    // longer gaps between two snapshots (link lost, car switched off) are
+    // not integrated over
+    static constexpr qint64 maxIntegrationGap = 2000;
+    // energyPerKm stays 0 below this distance in km, it is meaningless before
+    static constexpr double minEnergyPerKmDistance = 0.05;
+
+    void update(const TelemetrySnapshot &telemetry);
+    // starts a new trip, the instantaneous values are kept
+    void resetTrip();
+
+    // km/h, mean over all wheels
+    float avgSpeed() const { return m_avgSpeed; }
+    // V, mean of both boards
+    float avgVoltage() const { return m_avgVoltage; }
+    // A, sum over all motors, negative while regenerating
+    float totalCurrent() const { return m_totalCurrent; }
+    // W, negative while regenerating
+    float totalPower() const { return m_totalPower; }
+
+    // km
+    double tripDistance() const { return m_tripDistance; }
+    // s the car was streaming during the trip
+    double tripTime() const { return m_tripTime; }
+    // Wh drawn from and fed back into the battery
+    double energyConsumed() const { return m_energyConsumed; }
+    double energyRegenerated() const { return m_energyRegenerated; }
+    // net Wh per km of the trip
+    double energyPerKm() const;
+    // W, highest power drawn during the trip
+    float peakPower() const { return m_peakPower; }
+
+private:
+    float m_avgSpeed{};
+    float m_avgVoltage{};
+    float m_totalCurrent{};
+    float m_totalPower{};
+
+    double m_tripDistance{};
+    double m_tripTime{};
+    double m_energyConsumed{};
+    double m_energyRegenerated{};
+    float m_peakPower{};
+
+    // ms timestamp of the previous snapshot, -1 before the first one
+    qint64 m_lastTimestamp{-1};
+};
+
+Q_DECLARE_METATYPE(DrivingMetrics)
@@ -0,0 +1,213 @@
+#include "fleetmanager.h"
+
+// system includes
+#include <algorithm>
+
+// Qt includes
+#include <QDebug>
+#include <QQmlEngine>
+
+// local includes
+#include "devicehandler.h"
+
+FleetManager::FleetManager(QObject *parent) :
+    QAbstractListModel{parent},
+    m_refreshTimer{this}
+{
+    m_refreshTimer.setInterval(50);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &FleetManager::refresh);
+
+    m_workerThread.setObjectName(QStringLiteral("FleetWorker"));
+    m_workerThread.start(QThread::HighPriority);
+}
+
+FleetManager::~FleetManager()
+{
+    // including removed cars still waiting for deleteLater(), all of them
+    // need the worker thread running
+    qDeleteAll(findChildren<DeviceHandler *>(QString{}, Qt::FindDirectChildrenOnly));
+
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void FleetManager::setFinder(DeviceFinder *finder)
+{
+    if (m_finder == finder)
+        return;
+
+    m_finder = finder;
+    emit finderChanged();
+}
+
+void FleetManager::setRefreshInterval(int refreshInterval)
+{
+    refreshInterval = std::max(1, refreshInterval);
+    if (m_refreshTimer.interval() == refreshInterval)
+        return;
+
+    m_refreshTimer.setInterval(refreshInterval);
+    emit refreshIntervalChanged();
+}
+
+bool FleetManager::addCar(const QString &deviceId)
+{
+    QBluetoothDeviceInfo info;
+    if (!m_finder || !m_finder->findDevice(deviceId, info))
+    {
+        qWarning() << "could not find device" << deviceId;
+        return false;
+    }
+
+    if (int(m_cars.size()) >= maxCars)
+    {
+        qWarning() << "fleet is full";
+        return false;
+    }
+
+    if (std::any_of(std::cbegin(m_cars), std::cend(m_cars), [&deviceId](const Car &car){ return DeviceFinder::deviceId(car.info) == deviceId; }))
+        return false;
+
+    auto handler = new DeviceHandler{m_workerThread, historyBudget / maxCars, this};
+    QQmlEngine::setObjectOwnership(handler, QQmlEngine::CppOwnership);
+    if (m_transportFactory)
+        handler->setTransport(m_transportFactory());
+
+    connect(handler, &DeviceHandler::aliveChanged, this, [this, handler]() { carChanged(handler, {AliveRole}); });
+    connect(handler, &DeviceHandler::errorChanged, this, [this, handler]() { carChanged(handler, {ErrorRole}); });
+    connect(handler, &DeviceHandler::infoChanged, this, [this, handler]() { carChanged(handler, {InfoRole}); });
+
+    const int row = int(m_cars.size());
+    beginInsertRows({}, row, row);
+    m_cars.push_back(Car{info, handler});
+    endInsertRows();
+    emit countChanged();
+
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+
+    handler->setDevice(info);
+    return true;
+}
+
+void FleetManager::removeCar(int row)
+{
+    if (row < 0 || row >= int(m_cars.size()))
+    {
+        qWarning() << "row out of bounds" << row;
+        return;
+    }
+
+    DeviceHandler *handler = m_cars[row].handler;
+
+    beginRemoveRows({}, row, row);
+    m_cars.erase(std::begin(m_cars) + row);
+    endRemoveRows();
+    emit countChanged();
+
+    if (m_cars.empty())
+        m_refreshTimer.stop();
+
+    handler->disconnect(this);
+    handler->disconnectService();
+    handler->deleteLater();
+}
+
+DeviceHandler *FleetManager::handler(int row) const
+{
+    if (row < 0 || row >= int(m_cars.size()))
+        return nullptr;
+
+    return m_cars[row].handler;
+}
+
+int FleetManager::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return int(m_cars.size());
+}
+
+QVariant FleetManager::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= int(m_cars.size()))
+    {
+        qWarning() << "invalid index" << index;
+        return {};
+    }
+
+    const Car &car = m_cars[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+    case NameRole:
+        return car.info.name();
+    case AddressRole:
+        return car.info.address().toString();
+    case AliveRole:
+        return car.handler->alive();
+    case ErrorRole:
+        return car.handler->error();
+    case InfoRole:
+        return car.handler->info();
+    case TelemetryRole:
+        return QVariant::fromValue(car.handler->telemetry());
+    case HandlerRole:
+        return QVariant::fromValue(car.handler);
+    }
+
+    return {};
+}
+
+QHash<int, QByteArray> FleetManager::roleNames() const
+{
+    return QHash<int, QByteArray> {
+        { NameRole, QByteArrayLiteral("name") },
+        { AddressRole, QByteArrayLiteral("address") },
+        { AliveRole, QByteArrayLiteral("alive") },
+        { ErrorRole, QByteArrayLiteral("error") },
+        { InfoRole, QByteArrayLiteral("info") },
+        { TelemetryRole, QByteArrayLiteral("telemetry") },
+        { HandlerRole, QByteArrayLiteral("handler") }
+    };
+}
+
+int FleetManager::rowOf(const DeviceHandler *handler) const
+{
+    const auto iter = std::find_if(std::cbegin(m_cars), std::cend(m_cars), [handler](const Car &car){
+        return car.handler == handler;
+    });
+
+    return iter == std::cend(m_cars) ? -1 : int(std::distance(std::cbegin(m_cars), iter));
+}
+
+void FleetManager::carChanged(const DeviceHandler *handler, const QVector<int> &roles)
+{
+    const int row = rowOf(handler);
+    if (row < 0)
+        return;
+
+    const QModelIndex index = createIndex(row, 0);
+    emit dataChanged(index, index, roles);
+}
+
+void FleetManager::refresh()
+{
+    int first = -1;
+    int last = -1;
+
+    for (int row = 0; row < int(m_cars.size()); row++)
+    {
+        if (!m_cars[row].handler->drainTelemetry())
+            continue;
+
+        if (first < 0)
+            first = row;
+        last = row;
+    }
+
+    if (first >= 0)
+        emit dataChanged(createIndex(first, 0), createIndex(last, 0), {TelemetryRole});
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// system includes
+#include <functional>
+#include <vector>
+
+// Qt includes
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+#include <QBluetoothDeviceInfo>
+
+// local includes
+#include "devicefinder.h"
+#include "telemetryhistory.h"
+
+// forward declares
+class DeviceHandler;
+class BobbycarTransport;
+
+// Keeps connections to several bobbycars at once. Every car gets its own
+// DeviceHandler with its own telemetry and control state, their workers all
+// run on one shared thread. Cars are added from the DeviceFinder that is
+// already scanning, e.g. the one of the connect page.
+//
+// Telemetry of all cars is taken over on one timer tick per refresh
+// interval and published with a single dataChanged(), so the GUI thread
+// load does not grow with the number of cars times their livestats rate.
+class FleetManager : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(DeviceFinder* finder READ finder WRITE setFinder NOTIFY finderChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+
+public:
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        AddressRole,
+        AliveRole,
+        ErrorRole,
+        InfoRole,
+        TelemetryRole,
+        HandlerRole
+    };
+
+    static constexpr int maxCars = 8;
+    // history samples of all cars together, every car gets an equal share
+    static constexpr int historyBudget = TelemetryHistory::defaultCapacity;
+
+    explicit FleetManager(QObject *parent = nullptr);
+    ~FleetManager() override;
+
+    // not owned, cleared when the finder is destroyed
+    DeviceFinder *finder() { return m_finder; }
+    void setFinder(DeviceFinder *finder);
+
+    int count() const { return int(m_cars.size()); }
+
+    // milliseconds between telemetry updates of the model
+    int refreshInterval() const { return m_refreshTimer.interval(); }
+    void setRefreshInterval(int refreshInterval);
+
+    // used for every car added afterwards, defaults to Bluetooth
+    void setTransportFactory(std::function<BobbycarTransport *()> transportFactory) { m_transportFactory = std::move(transportFactory); }
+
+    // connects to a device found by finder(), false if it is unknown,
+    // already part of the fleet or the fleet is full
+    Q_INVOKABLE bool addCar(const QString &deviceId);
+    Q_INVOKABLE void removeCar(int row);
+    Q_INVOKABLE DeviceHandler *handler(int row) const;
+
+    // QAbstractItemModel interface
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void finderChanged();
+    void countChanged();
+    void refreshIntervalChanged();
+
+private:
+    struct Car
+    {
+        QBluetoothDeviceInfo info;
+        DeviceHandler *handler;
+    };
+
+    int rowOf(const DeviceHandler *handler) const;
+    void carChanged(const DeviceHandler *handler, const QVector<int> &roles);
+    void refresh();
+
+    QPointer<DeviceFinder> m_finder;
+    // declared before the cars, their workers are deleted on it
+    QThread m_workerThread;
+    std::vector<Car> m_cars;
+    QTimer m_refreshTimer;
+    std::function<BobbycarTransport *()> m_transportFactory;
+};
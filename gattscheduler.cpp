@@ -0,0 +1,300 @@
+#include "gattscheduler.h"
+
+// system includes
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Qt includes
+#include <QDebug>
+
+// local includes
+#include "bobbycartransport.h"
+#include "tracing.h"
+
+GattScheduler::GattScheduler(QObject *parent) :
+    QObject{parent},
+    m_timeoutTimer{this}
+{
+    m_clock.start();
+
+    m_timeoutTimer.setSingleShot(true);
+    connect(&m_timeoutTimer, &QTimer::timeout, this, &GattScheduler::expire);
+}
+
+void GattScheduler::setTransport(BobbycarTransport *transport)
+{
+    if (m_transport)
+        m_transport->disconnect(this);
+
+    clear();
+
+    m_transport = transport;
+    if (!m_transport)
+        return;
+
+    connect(m_transport, &BobbycarTransport::characteristicWritten, this, &GattScheduler::characteristicWritten);
+    connect(m_transport, &BobbycarTransport::writeFailed, this, &GattScheduler::transportWriteFailed);
+    connect(m_transport, &BobbycarTransport::descriptorWritten, this, &GattScheduler::descriptorWritten);
+}
+
+void GattScheduler::setMaxInFlight(int maxInFlight)
+{
+    m_maxInFlight = std::max(1, maxInFlight);
+    dispatch();
+}
+
+void GattScheduler::setControlPending(bool controlPending)
+{
+    if (m_controlPending == controlPending)
+        return;
+
+    m_controlPending = controlPending;
+    if (!m_controlPending)
+        dispatch();
+}
+
+void GattScheduler::write(GattPriority priority, const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse, bool coalesce)
+{
+    enqueue(Operation{withResponse ? Kind::Write : Kind::WriteWithoutResponse, priority, uuid, value}, coalesce);
+}
+
+void GattScheduler::setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled)
+{
+    // only the last state asked for matters
+    enqueue(Operation{Kind::Descriptor, GattPriority::Background, uuid, {}, enabled}, true);
+}
+
+void GattScheduler::clear()
+{
+    for (auto &queue : m_queues)
+        queue.clear();
+    m_inFlight.clear();
+    m_timeoutTimer.stop();
+
+    emit statsChanged();
+}
+
+int GattScheduler::queued() const
+{
+    int queued{};
+    for (const auto &queue : m_queues)
+        queued += int(queue.size());
+    return queued;
+}
+
+int GattScheduler::inFlight() const
+{
+    return int(std::count_if(std::begin(m_inFlight), std::end(m_inFlight), [](const Operation &operation){
+        return !operation.expired;
+    }));
+}
+
+GattQueueStats GattScheduler::stats() const
+{
+    GattQueueStats stats;
+    stats.m_queued = queued();
+    stats.m_inFlight = inFlight();
+    stats.m_superseded = m_superseded;
+    stats.m_timedOut = m_timedOut;
+    stats.m_controlWait = LatencyStats{m_waitTimes[int(GattPriority::Control)]};
+    stats.m_settingsWait = LatencyStats{m_waitTimes[int(GattPriority::Settings)]};
+    stats.m_backgroundWait = LatencyStats{m_waitTimes[int(GattPriority::Background)]};
+    return stats;
+}
+
+void GattScheduler::resetStats()
+{
+    for (auto &histogram : m_waitTimes)
+        histogram.reset();
+    m_superseded = 0;
+    m_timedOut = 0;
+
+    emit statsChanged();
+}
+
+void GattScheduler::enqueue(Operation &&operation, bool coalesce)
+{
+    operation.queued = now();
+
+    auto &queue = m_queues[int(operation.priority)];
+
+    const auto iter = !coalesce ? std::end(queue) : std::find_if(std::begin(queue), std::end(queue), [&operation](const Operation &queued){
+        return queued.kind == operation.kind && queued.uuid == operation.uuid;
+    });
+
+    if (iter != std::end(queue))
+    {
+        // keeps its place in the queue and its wait time, only the payload is newer
+        iter->value = std::move(operation.value);
+        iter->enabled = operation.enabled;
+        m_superseded++;
+        emit superseded(iter->uuid);
+    }
+    else
+        queue.push_back(std::move(operation));
+
+    dispatch();
+    emit statsChanged();
+}
+
+void GattScheduler::dispatch()
+{
+    if (!m_transport || !m_transport->isReady())
+        return;
+
+    for (int priority = 0; priority < gattPriorityCount; priority++)
+    {
+        auto &queue = m_queues[priority];
+        const bool control = priority == int(GattPriority::Control);
+
+        // the held back frame goes out as soon as a confirmation arrives, a
+        // settings write handed out now would be in its way
+        if (!control && m_controlPending)
+            return;
+
+        while (!queue.empty())
+        {
+            const bool acknowledged = queue.front().kind != Kind::WriteWithoutResponse;
+            const int maxInFlight = control ? m_maxInFlight + reservedControlSlots : m_maxInFlight;
+
+            // strictly by priority, lower classes must not take the slot the
+            // waiting operation needs
+            if (acknowledged && inFlight() >= maxInFlight)
+                return;
+
+            Operation operation = std::move(queue.front());
+            queue.pop_front();
+
+            const qint64 timestamp = now();
+            m_waitTimes[int(operation.priority)].record(timestamp - operation.queued);
+            BOBBYCAR_TRACE(lcGatt, TraceEvent::GattDispatch, int(operation.priority), timestamp - operation.queued);
+
+            if (acknowledged)
+            {
+                operation.deadline = timestamp + qint64(timeout(operation.priority)) * 1000;
+                m_inFlight.push_back(operation);
+                armTimeout();
+            }
+
+            // the transport never confirms synchronously, so the in flight
+            // entry is always there before its confirmation
+            switch (operation.kind)
+            {
+            case Kind::Write:
+                m_transport->writeCharacteristic(operation.uuid, operation.value, true);
+                break;
+            case Kind::WriteWithoutResponse:
+                m_transport->writeCharacteristic(operation.uuid, operation.value, false);
+                break;
+            case Kind::Descriptor:
+                m_transport->setNotificationsEnabled(operation.uuid, operation.enabled);
+                break;
+            }
+        }
+    }
+}
+
+bool GattScheduler::complete(Kind kind, const QBluetoothUuid &uuid)
+{
+    const auto iter = std::find_if(std::begin(m_inFlight), std::end(m_inFlight), [kind, &uuid](const Operation &operation){
+        return operation.kind == kind && operation.uuid == uuid;
+    });
+
+    // expired long ago or not ours
+    if (iter == std::end(m_inFlight))
+        return false;
+
+    // the late confirmation of an operation already reported as timed out
+    const bool expired = iter->expired;
+
+    m_inFlight.erase(iter);
+    armTimeout();
+    return !expired;
+}
+
+void GattScheduler::expire()
+{
+    const qint64 timestamp = now();
+
+    // collected first, the slots connected to writeFailed() may enqueue
+    std::vector<QBluetoothUuid> failedWrites;
+    for (auto iter = std::begin(m_inFlight); iter != std::end(m_inFlight);)
+    {
+        if (iter->deadline > timestamp)
+        {
+            ++iter;
+            continue;
+        }
+
+        // no late confirmation within another timeout, it is not coming
+        if (iter->expired)
+        {
+            iter = m_inFlight.erase(iter);
+            continue;
+        }
+
+        qWarning() << "GATT operation timed out" << iter->uuid;
+        BOBBYCAR_TRACE(lcGatt, TraceEvent::GattTimeout, int(iter->priority), timestamp - iter->deadline);
+        m_timedOut++;
+        if (iter->kind == Kind::Write)
+            failedWrites.push_back(iter->uuid);
+
+        // lets go of the caller's buffer, only the confirmation is awaited
+        iter->value = QByteArray{};
+        iter->expired = true;
+        iter->deadline = timestamp + qint64(timeout(iter->priority)) * 1000;
+        ++iter;
+    }
+
+    armTimeout();
+
+    for (const auto &uuid : failedWrites)
+        emit writeFailed(uuid);
+
+    dispatch();
+    emit statsChanged();
+}
+
+void GattScheduler::armTimeout()
+{
+    if (m_inFlight.empty())
+    {
+        m_timeoutTimer.stop();
+        return;
+    }
+
+    qint64 deadline = std::numeric_limits<qint64>::max();
+    for (const auto &operation : m_inFlight)
+        deadline = std::min(deadline, operation.deadline);
+
+    m_timeoutTimer.start(int(std::max<qint64>(0, (deadline - now() + 999) / 1000)));
+}
+
+void GattScheduler::characteristicWritten(const QBluetoothUuid &uuid, const QByteArray &value)
+{
+    if (complete(Kind::Write, uuid))
+        emit written(uuid, value);
+
+    dispatch();
+    emit statsChanged();
+}
+
+void GattScheduler::transportWriteFailed(const QBluetoothUuid &uuid)
+{
+    if (complete(Kind::Write, uuid))
+        emit writeFailed(uuid);
+
+    dispatch();
+    emit statsChanged();
+}
+
+void GattScheduler::descriptorWritten(const QBluetoothUuid &uuid, bool enabled)
+{
+    Q_UNUSED(enabled)
+
+    complete(Kind::Descriptor, uuid);
+
+    dispatch();
+    emit statsChanged();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+// system includes
+#include <array>
+#include <deque>
+
+// Qt includes
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QBluetoothUuid>
+#include <QByteArray>
+
+// local includes
+#include "latencyhistogram.h"
+
+// forward declares
+class BobbycarTransport;
+
+// Lower values are dispatched first.
+enum class GattPriority {
+    // control frames, including the stop frame sent when remote control ends
+    Control,
+    // writes to the settings characteristic
+    Settings,
+    // reads and descriptor writes
+    Background
+};
+
+constexpr int gattPriorityCount = 3;
+
+// Queue depth and wait times of a GattScheduler for QML. Waits are measured
+// from enqueueing until the operation is handed to the transport, in ms.
+class GattQueueStats
+{
+    Q_GADGET
+    Q_PROPERTY(int queued READ queued)
+    Q_PROPERTY(int inFlight READ inFlight)
+    Q_PROPERTY(int superseded READ superseded)
+    Q_PROPERTY(int timedOut READ timedOut)
+    Q_PROPERTY(LatencyStats controlWait READ controlWait)
+    Q_PROPERTY(LatencyStats settingsWait READ settingsWait)
+    Q_PROPERTY(LatencyStats backgroundWait READ backgroundWait)
+
+public:
+    int queued() const { return m_queued; }
+    int inFlight() const { return m_inFlight; }
+    int superseded() const { return m_superseded; }
+    int timedOut() const { return m_timedOut; }
+    LatencyStats controlWait() const { return m_controlWait; }
+    LatencyStats settingsWait() const { return m_settingsWait; }
+    LatencyStats backgroundWait() const { return m_backgroundWait; }
+
+private:
+    friend class GattScheduler;
+
+    int m_queued{};
+    int m_inFlight{};
+    int m_superseded{};
+    int m_timedOut{};
+    LatencyStats m_controlWait;
+    LatencyStats m_settingsWait;
+    LatencyStats m_backgroundWait;
+};
+
+Q_DECLARE_METATYPE(GattQueueStats)
+
+// Serializes all GATT operations of a DeviceWorker. Operations are queued per
+// priority and dispatched strictly by priority, acknowledged ones limited to
+// maxInFlight() at a time plus a slot only control frames may use, so a burst
+// of settings or descriptor traffic never keeps a control frame waiting for
+// the scheduler.
+// A queued (not yet dispatched) operation on the same characteristic and
+// priority is replaced instead of queueing another one. Acknowledged
+// operations that are not confirmed within the timeout of their priority are
+// reported as failed. They stay behind without taking a slot for another
+// timeout, so a late confirmation is not taken for the one of a later
+// operation on the same characteristic.
+class GattScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GattScheduler(QObject *parent = nullptr);
+
+    void setTransport(BobbycarTransport *transport);
+
+    // acknowledged operations of the Control class handed to the transport
+    // on top of maxInFlight()
+    static constexpr int reservedControlSlots = 1;
+
+    // acknowledged operations handed to the transport at a time, ATT itself
+    // only allows one request outstanding
+    int maxInFlight() const { return m_maxInFlight; }
+    void setMaxInFlight(int maxInFlight);
+
+    // the caller holds back a control frame until one of its writes is
+    // confirmed, lower classes are not dispatched meanwhile
+    bool controlPending() const { return m_controlPending; }
+    void setControlPending(bool controlPending);
+
+    // ms until an acknowledged operation of the priority counts as failed
+    int timeout(GattPriority priority) const { return m_timeouts[int(priority)]; }
+    void setTimeout(GattPriority priority, int timeout) { m_timeouts[int(priority)] = timeout; }
+
+    // with coalesce a still queued write to the same characteristic gets
+    // the new value instead (reported through superseded()), only for callers
+    // that do not count on one confirmation per write
+    void write(GattPriority priority, const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse = true, bool coalesce = false);
+    void setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled);
+
+    // drops everything queued and in flight without reporting it, for when
+    // the link went down
+    void clear();
+
+    int queued() const;
+    int inFlight() const;
+
+    GattQueueStats stats() const;
+    void resetStats();
+
+signals:
+    void written(const QBluetoothUuid &uuid, const QByteArray &value);
+    void writeFailed(const QBluetoothUuid &uuid);
+    // the value of a queued write was replaced by a newer one
+    void superseded(const QBluetoothUuid &uuid);
+    // on every enqueue, dispatch and completion, only meant to mark stats()
+    // outdated, not to build them every time
+    void statsChanged();
+
+private:
+    enum class Kind {
+        Write,
+        WriteWithoutResponse,
+        Descriptor
+    };
+
+    struct Operation
+    {
+        Kind kind;
+        GattPriority priority;
+        QBluetoothUuid uuid;
+        // shares the caller's buffer until completed, callers writing often
+        // encode into a ring of buffers instead of one reused buffer
+        QByteArray value;
+        bool enabled{};
+        // µs of m_clock, enqueueing resp. dispatching
+        qint64 queued{};
+        qint64 deadline{};
+        // reported as timed out, only waits for its late confirmation
+        bool expired{};
+    };
+
+    void enqueue(Operation &&operation, bool coalesce);
+    void dispatch();
+    // false if the operation was not in flight (anymore), also when the
+    // confirmation belonged to an expired one
+    bool complete(Kind kind, const QBluetoothUuid &uuid);
+    void expire();
+    void armTimeout();
+
+    //BobbycarTransport
+    void characteristicWritten(const QBluetoothUuid &uuid, const QByteArray &value);
+    void transportWriteFailed(const QBluetoothUuid &uuid);
+    void descriptorWritten(const QBluetoothUuid &uuid, bool enabled);
+
+    qint64 now() const { return m_clock.nsecsElapsed() / 1000; }
+
+    BobbycarTransport *m_transport{};
+
+    std::array<std::deque<Operation>, gattPriorityCount> m_queues;
+    // dispatched, in order, confirmations of equal characteristics arrive in
+    // the same order, expired ones included
+    std::deque<Operation> m_inFlight;
+    int m_maxInFlight{1};
+    bool m_controlPending{};
+    std::array<int, gattPriorityCount> m_timeouts{{1000, 3000, 5000}};
+
+    QElapsedTimer m_clock;
+    QTimer m_timeoutTimer;
+
+    std::array<LatencyHistogram, gattPriorityCount> m_waitTimes;
+    int m_superseded{};
+    int m_timedOut{};
+};
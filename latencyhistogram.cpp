@@ -0,0 +1,97 @@
+#include "latencyhistogram.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Qt includes
+#include <QtAlgorithms>
+
+void LatencyHistogram::record(qint64 micros)
+{
+    micros = std::max<qint64>(0, micros);
+
+    m_buckets[bucketIndex(micros)]++;
+    m_count++;
+    m_sum += micros;
+    m_max = std::max(m_max, micros);
+}
+
+void LatencyHistogram::reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+qint64 LatencyHistogram::percentile(double quantile) const
+{
+    if (!m_count)
+        return 0;
+
+    const qint64 rank = std::max<qint64>(1, qint64(std::ceil(std::clamp(quantile, 0., 1.) * m_count)));
+
+    qint64 seen{};
+    for (int i = 0; i < bucketCount; i++)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            if (i == bucketCount - 1)
+                return m_max;
+            return std::min(bucketLowerBound(i + 1) - 1, m_max);
+        }
+    }
+
+    return m_max;
+}
+
+qint64 LatencyHistogram::bucketLowerBound(int index)
+{
+    if (index < subBucketCount)
+        return index;
+
+    const int exponent = index / subBucketCount + subBucketBits - 1;
+    const int subBucket = index % subBucketCount;
+    return qint64(subBucketCount + subBucket) << (exponent - subBucketBits);
+}
+
+void LatencyHistogram::write(QTextStream &stream, const char *name) const
+{
+    stream << "# " << name
+           << " count=" << m_count
+           << " mean_us=" << qint64(mean())
+           << " p50_us=" << percentile(.5)
+           << " p95_us=" << percentile(.95)
+           << " p99_us=" << percentile(.99)
+           << " max_us=" << m_max << '\n';
+
+    for (int i = 0; i < bucketCount; i++)
+        if (m_buckets[i])
+            stream << bucketLowerBound(i) << ' ' << m_buckets[i] << '\n';
+}
+
+int LatencyHistogram::bucketIndex(qint64 micros)
+{
+    if (micros < subBucketCount)
+        return int(micros);
+
+    const int exponent = 63 - qCountLeadingZeroBits(quint64(micros));
+    if (exponent > maxExponent)
+        return bucketCount - 1;
+
+    const int subBucket = int(micros >> (exponent - subBucketBits)) & (subBucketCount - 1);
+    return (exponent - subBucketBits + 1) * subBucketCount + subBucket;
+}
+
+LatencyStats::LatencyStats(const LatencyHistogram &histogram) :
+    m_count{int(std::min<qint64>(histogram.count(), std::numeric_limits<int>::max()))},
+    m_p50{histogram.percentile(.5) / 1000.},
+    m_p95{histogram.percentile(.95) / 1000.},
+    m_p99{histogram.percentile(.99) / 1000.},
+    m_max{histogram.max() / 1000.},
+    m_mean{histogram.mean() / 1000.}
+{
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// system includes
+#include <array>
+
+// Qt includes
+#include <QMetaType>
+#include <QTextStream>
+#include <QtGlobal>
+
+// Fixed-size latency histogram in microseconds. Buckets are exact below 8 µs
+// and log-linear above (8 buckets per power of two, so every bucket is at most
+// 12.5% wide), values from ~134 s on land in the last bucket. Recording never
+// allocates, the maximum is tracked exactly.
+class LatencyHistogram
+{
+public:
+    static constexpr int subBucketBits = 3;
+    static constexpr int subBucketCount = 1 << subBucketBits;
+    static constexpr int maxExponent = 26;
+    static constexpr int bucketCount = (maxExponent - subBucketBits + 2) * subBucketCount;
+
+    void record(qint64 micros);
+    void reset();
+
+    qint64 count() const { return m_count; }
+    qint64 max() const { return m_max; }
+    double mean() const { return m_count ? double(m_sum) / m_count : 0.; }
+
+    // upper bound of the bucket holding the given quantile (0..1), never
+    // above the recorded maximum
+    qint64 percentile(double quantile) const;
+
+    quint32 bucket(int index) const { return m_buckets[index]; }
+    static qint64 bucketLowerBound(int index);
+
+    // text dump: summary line followed by "lower_bound_us count" for every
+    // non empty bucket
+    void write(QTextStream &stream, const char *name) const;
+
+private:
+    static int bucketIndex(qint64 micros);
+
+    std::array<quint32, bucketCount> m_buckets{};
+    qint64 m_count{};
+    qint64 m_sum{};
+    qint64 m_max{};
+};
+
+// Percentile summary of a LatencyHistogram for QML, all values in
+// milliseconds.
+class LatencyStats
+{
+    Q_GADGET
+    Q_PROPERTY(int count READ count)
+    Q_PROPERTY(double p50 READ p50)
+    Q_PROPERTY(double p95 READ p95)
+    Q_PROPERTY(double p99 READ p99)
+    Q_PROPERTY(double max READ max)
+    Q_PROPERTY(double mean READ mean)
+
+public:
+    LatencyStats() = default;
+    explicit LatencyStats(const LatencyHistogram &histogram);
+
+    int count() const { return m_count; }
+    double p50() const { return m_p50; }
+    double p95() const { return m_p95; }
+    double p99() const { return m_p99; }
+    double max() const { return m_max; }
+    double mean() const { return m_mean; }
+
+private:
+    int m_count{};
+    double m_p50{};
+    double m_p95{};
+    double m_p99{};
+    double m_max{};
+    double m_mean{};
+};
+
+Q_DECLARE_METATYPE(LatencyStats)
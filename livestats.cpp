@@ -0,0 +1,519 @@
+#include "livestats.h"
+
+// Qt includes
+#include <QtEndian>
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace {
+float readScaled(const char *ptr, float scale)
+{
+    return qFromLittleEndian<qint16>(ptr) / scale;
+}
+
+void writeScaled(char *ptr, float value, float scale)
+{
+    const float scaled = std::clamp(std::round(value * scale),
+                                    float(std::numeric_limits<qint16>::min()),
+                                    float(std::numeric_limits<qint16>::max()));
+    qToLittleEndian<qint16>(qint16(scaled), ptr);
+}
+
+// like QJsonValue::toInt(), which the DOM based parser used: values that are
+// not integers in int range read as 0
+int toInt(double value)
+{
+    if (value != std::floor(value) ||
+        value < double(std::numeric_limits<int>::min()) ||
+        value > double(std::numeric_limits<int>::max()))
+        return 0;
+    return int(value);
+}
+
+// the binary frame carries error codes as u8
+char toErrorByte(int error)
+{
+    return char(std::clamp(error, 0, 255));
+}
+
+void appendJsonArray(QByteArray &buffer, char key, std::initializer_list<double> values, int precision)
+{
+    buffer += '"';
+    buffer += key;
+    buffer += "\":[";
+    bool first = true;
+    for (const double value : values)
+    {
+        if (!first)
+            buffer += ',';
+        first = false;
+        buffer += QByteArray::number(value, 'f', precision);
+    }
+    buffer += ']';
+}
+
+// Single pass parser for the livestats JSON schema
+// ({"v":[..],"t":[..],"e":[..],"s":[..],"a":[..]}). Reads straight out of the
+// notification buffer without building a DOM, unknown keys are skipped.
+// Missing keys and non-numeric array entries read as 0, like QJsonValue does.
+class LivestatsJsonParser
+{
+public:
+    explicit LivestatsJsonParser(const QByteArray &value) :
+        m_ptr{value.constData()},
+        m_end{value.constData() + value.size()}
+    {}
+
+    bool parse(Livestats &livestats);
+
+    const char *error() const { return m_error; }
+
+private:
+    static constexpr int maxDepth = 32;
+
+    bool fail(const char *error) { m_error = error; return false; }
+
+    void skipWhitespace();
+    bool parseKey(char &key);
+    bool skipString();
+    bool parseNumber(double &result);
+    bool parseNumberArray(double *values, int count);
+    bool skipValue(int depth);
+    bool skipLiteral(const char *literal);
+
+    const char *m_ptr;
+    const char * const m_end;
+    const char *m_error{};
+};
+
+bool LivestatsJsonParser::parse(Livestats &livestats)
+{
+    double voltages[2]{};
+    double temperatures[2]{};
+    double errors[4]{};
+    double speeds[4]{};
+    double dcLinks[4]{};
+
+    skipWhitespace();
+    if (m_ptr == m_end || *m_ptr != '{')
+        return fail("livestats is not a JSON object");
+    ++m_ptr;
+
+    skipWhitespace();
+    if (m_ptr != m_end && *m_ptr == '}')
+        ++m_ptr;
+    else
+    {
+        while (true)
+        {
+            char key;
+            if (!parseKey(key))
+                return false;
+
+            skipWhitespace();
+            if (m_ptr == m_end || *m_ptr != ':')
+                return fail("missing name separator");
+            ++m_ptr;
+            skipWhitespace();
+
+            bool ok;
+            const bool isArray = m_ptr != m_end && *m_ptr == '[';
+            switch (isArray ? key : '\0')
+            {
+            case 'v': ok = parseNumberArray(voltages, 2); break;
+            case 't': ok = parseNumberArray(temperatures, 2); break;
+            case 'e': ok = parseNumberArray(errors, 4); break;
+            case 's': ok = parseNumberArray(speeds, 4); break;
+            case 'a': ok = parseNumberArray(dcLinks, 4); break;
+            default: ok = skipValue(1);
+            }
+            if (!ok)
+                return false;
+
+            skipWhitespace();
+            if (m_ptr == m_end)
+                return fail("unterminated object");
+            if (*m_ptr == '}')
+            {
+                ++m_ptr;
+                break;
+            }
+            if (*m_ptr != ',')
+                return fail("missing value separator");
+            ++m_ptr;
+            skipWhitespace();
+        }
+    }
+
+    skipWhitespace();
+    if (m_ptr != m_end && *m_ptr != '\0')
+        return fail("garbage at the end of the document");
+
+    livestats.frontVoltage = voltages[0];
+    livestats.backVoltage = voltages[1];
+    livestats.frontTemperature = temperatures[0];
+    livestats.backTemperature = temperatures[1];
+    livestats.frontLeftError = toInt(errors[0]);
+    livestats.frontRightError = toInt(errors[1]);
+    livestats.backLeftError = toInt(errors[2]);
+    livestats.backRightError = toInt(errors[3]);
+    livestats.frontLeftSpeed = speeds[0];
+    livestats.frontRightSpeed = speeds[1];
+    livestats.backLeftSpeed = speeds[2];
+    livestats.backRightSpeed = speeds[3];
+    livestats.frontLeftDcLink = dcLinks[0];
+    livestats.frontRightDcLink = dcLinks[1];
+    livestats.backLeftDcLink = dcLinks[2];
+    livestats.backRightDcLink = dcLinks[3];
+
+    return true;
+}
+
+void LivestatsJsonParser::skipWhitespace()
+{
+    while (m_ptr != m_end && (*m_ptr == ' ' || *m_ptr == '\t' || *m_ptr == '\n' || *m_ptr == '\r'))
+        ++m_ptr;
+}
+
+bool LivestatsJsonParser::parseKey(char &key)
+{
+    if (m_ptr == m_end || *m_ptr != '"')
+        return fail("illegal value");
+
+    const char *begin = m_ptr + 1;
+    if (!skipString())
+        return false;
+
+    // m_ptr now points behind the closing quote
+    key = (m_ptr - begin == 2) ? *begin : '\0';
+    return true;
+}
+
+bool LivestatsJsonParser::skipString()
+{
+    ++m_ptr; // opening quote
+
+    while (m_ptr != m_end)
+    {
+        const char c = *m_ptr++;
+        if (c == '"')
+            return true;
+        if (c == '\\')
+        {
+            if (m_ptr == m_end)
+                break;
+            ++m_ptr;
+        }
+        else if (uint8_t(c) < 0x20)
+            return fail("illegal value");
+    }
+
+    return fail("unterminated string");
+}
+
+bool LivestatsJsonParser::parseNumber(double &result)
+{
+    const char *ptr = m_ptr;
+
+    const bool negative = ptr != m_end && *ptr == '-';
+    if (negative)
+        ++ptr;
+
+    if (ptr == m_end || *ptr < '0' || *ptr > '9')
+        return fail("illegal number");
+
+    uint64_t mantissa{};
+    int exponent{};
+    int digits{};
+
+    const auto addDigit = [&](char c) {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + uint64_t(c - '0');
+            if (mantissa)
+                ++digits;
+            return true;
+        }
+        return false;
+    };
+
+    if (*ptr == '0')
+        ++ptr;
+    else
+        for (; ptr != m_end && *ptr >= '0' && *ptr <= '9'; ++ptr)
+            if (!addDigit(*ptr))
+                ++exponent;
+
+    if (ptr != m_end && *ptr == '.')
+    {
+        ++ptr;
+        if (ptr == m_end || *ptr < '0' || *ptr > '9')
+            return fail("illegal number");
+        for (; ptr != m_end && *ptr >= '0' && *ptr <= '9'; ++ptr)
+            if (addDigit(*ptr))
+                --exponent;
+    }
+
+    if (ptr != m_end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        ++ptr;
+        bool negativeExponent{};
+        if (ptr != m_end && (*ptr == '+' || *ptr == '-'))
+            negativeExponent = *ptr++ == '-';
+        if (ptr == m_end || *ptr < '0' || *ptr > '9')
+            return fail("illegal number");
+        int explicitExponent{};
+        for (; ptr != m_end && *ptr >= '0' && *ptr <= '9'; ++ptr)
+            if (explicitExponent < 10000)
+                explicitExponent = explicitExponent * 10 + (*ptr - '0');
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    m_ptr = ptr;
+
+    result = double(mantissa);
+    if (exponent)
+        result *= std::pow(10., exponent);
+    if (negative)
+        result = -result;
+
+    return true;
+}
+
+bool LivestatsJsonParser::parseNumberArray(double *values, int count)
+{
+    ++m_ptr; // [
+
+    skipWhitespace();
+    if (m_ptr != m_end && *m_ptr == ']')
+    {
+        ++m_ptr;
+        return true;
+    }
+
+    for (int i = 0; ; ++i)
+    {
+        skipWhitespace();
+        if (m_ptr == m_end)
+            return fail("unterminated array");
+
+        if (*m_ptr == '-' || (*m_ptr >= '0' && *m_ptr <= '9'))
+        {
+            double number;
+            if (!parseNumber(number))
+                return false;
+            if (i < count)
+                values[i] = number;
+        }
+        else if (!skipValue(2))
+            return false;
+
+        skipWhitespace();
+        if (m_ptr == m_end)
+            return fail("unterminated array");
+        if (*m_ptr == ']')
+        {
+            ++m_ptr;
+            return true;
+        }
+        if (*m_ptr != ',')
+            return fail("missing value separator");
+        ++m_ptr;
+    }
+}
+
+bool LivestatsJsonParser::skipValue(int depth)
+{
+    if (depth > maxDepth)
+        return fail("too deeply nested document");
+
+    skipWhitespace();
+    if (m_ptr == m_end)
+        return fail("illegal value");
+
+    switch (*m_ptr)
+    {
+    case '"':
+        return skipString();
+    case 't':
+        return skipLiteral("true");
+    case 'f':
+        return skipLiteral("false");
+    case 'n':
+        return skipLiteral("null");
+    case '[':
+    case '{':
+    {
+        const bool isObject = *m_ptr++ == '{';
+        const char close = isObject ? '}' : ']';
+
+        skipWhitespace();
+        if (m_ptr != m_end && *m_ptr == close)
+        {
+            ++m_ptr;
+            return true;
+        }
+
+        while (true)
+        {
+            skipWhitespace();
+            if (isObject)
+            {
+                char key;
+                if (!parseKey(key))
+                    return false;
+                skipWhitespace();
+                if (m_ptr == m_end || *m_ptr != ':')
+                    return fail("missing name separator");
+                ++m_ptr;
+            }
+
+            if (!skipValue(depth + 1))
+                return false;
+
+            skipWhitespace();
+            if (m_ptr == m_end)
+                return fail(isObject ? "unterminated object" : "unterminated array");
+            if (*m_ptr == close)
+            {
+                ++m_ptr;
+                return true;
+            }
+            if (*m_ptr != ',')
+                return fail("missing value separator");
+            ++m_ptr;
+        }
+    }
+    default:
+        if (*m_ptr == '-' || (*m_ptr >= '0' && *m_ptr <= '9'))
+        {
+            double number;
+            return parseNumber(number);
+        }
+        return fail("illegal value");
+    }
+}
+
+bool LivestatsJsonParser::skipLiteral(const char *literal)
+{
+    for (; *literal; ++literal, ++m_ptr)
+        if (m_ptr == m_end || *m_ptr != *literal)
+            return fail("illegal value");
+
+    return true;
+}
+} // namespace
+
+LivestatsFormat detectLivestatsFormat(const QByteArray &value)
+{
+    if (value.isEmpty())
+        return LivestatsFormat::Unknown;
+
+    const auto header = uint8_t(value.at(0));
+    if (header == livestatsBinaryVersion1)
+        return LivestatsFormat::BinaryV1;
+    if (header == livestatsFragmentMarker)
+        return LivestatsFormat::Fragment;
+    if (header < 0x20 && header != '\t' && header != '\n' && header != '\r')
+        return LivestatsFormat::Unknown;
+
+    return LivestatsFormat::Json;
+}
+
+bool parseLivestatsBinary(const QByteArray &value, Livestats &livestats, QString &errorString)
+{
+    if (value.isEmpty() || uint8_t(value.at(0)) != livestatsBinaryVersion1)
+    {
+        errorString = QStringLiteral("unsupported binary version");
+        return false;
+    }
+
+    if (value.size() < livestatsBinaryV1Size)
+    {
+        errorString = QStringLiteral("binary frame too short (%0 bytes)").arg(value.size());
+        return false;
+    }
+
+    const char *ptr = value.constData() + 1;
+
+    livestats.frontVoltage = readScaled(ptr + 0, 100.f);
+    livestats.backVoltage = readScaled(ptr + 2, 100.f);
+    livestats.frontTemperature = readScaled(ptr + 4, 10.f);
+    livestats.backTemperature = readScaled(ptr + 6, 10.f);
+    livestats.frontLeftError = uint8_t(ptr[8]);
+    livestats.frontRightError = uint8_t(ptr[9]);
+    livestats.backLeftError = uint8_t(ptr[10]);
+    livestats.backRightError = uint8_t(ptr[11]);
+    livestats.frontLeftSpeed = readScaled(ptr + 12, 100.f);
+    livestats.frontRightSpeed = readScaled(ptr + 14, 100.f);
+    livestats.backLeftSpeed = readScaled(ptr + 16, 100.f);
+    livestats.backRightSpeed = readScaled(ptr + 18, 100.f);
+    livestats.frontLeftDcLink = readScaled(ptr + 20, 100.f);
+    livestats.frontRightDcLink = readScaled(ptr + 22, 100.f);
+    livestats.backLeftDcLink = readScaled(ptr + 24, 100.f);
+    livestats.backRightDcLink = readScaled(ptr + 26, 100.f);
+
+    return true;
+}
+
+bool parseLivestatsJson(const QByteArray &value, Livestats &livestats, QString &errorString)
+{
+    LivestatsJsonParser parser{value};
+    if (!parser.parse(livestats))
+    {
+        errorString = QString::fromLatin1(parser.error());
+        return false;
+    }
+
+    return true;
+}
+
+void encodeLivestatsBinary(QByteArray &buffer, const Livestats &livestats)
+{
+    if (buffer.size() != livestatsBinaryV1Size)
+        buffer.resize(livestatsBinaryV1Size);
+
+    char *ptr = buffer.data();
+    ptr[0] = char(livestatsBinaryVersion1);
+    ptr++;
+
+    writeScaled(ptr + 0, livestats.frontVoltage, 100.f);
+    writeScaled(ptr + 2, livestats.backVoltage, 100.f);
+    writeScaled(ptr + 4, livestats.frontTemperature, 10.f);
+    writeScaled(ptr + 6, livestats.backTemperature, 10.f);
+    ptr[8] = toErrorByte(livestats.frontLeftError);
+    ptr[9] = toErrorByte(livestats.frontRightError);
+    ptr[10] = toErrorByte(livestats.backLeftError);
+    ptr[11] = toErrorByte(livestats.backRightError);
+    writeScaled(ptr + 12, livestats.frontLeftSpeed, 100.f);
+    writeScaled(ptr + 14, livestats.frontRightSpeed, 100.f);
+    writeScaled(ptr + 16, livestats.backLeftSpeed, 100.f);
+    writeScaled(ptr + 18, livestats.backRightSpeed, 100.f);
+    writeScaled(ptr + 20, livestats.frontLeftDcLink, 100.f);
+    writeScaled(ptr + 22, livestats.frontRightDcLink, 100.f);
+    writeScaled(ptr + 24, livestats.backLeftDcLink, 100.f);
+    writeScaled(ptr + 26, livestats.backRightDcLink, 100.f);
+}
+
+void encodeLivestatsJson(QByteArray &buffer, const Livestats &livestats)
+{
+    buffer.clear();
+    buffer += '{';
+    appendJsonArray(buffer, 'v', {livestats.frontVoltage, livestats.backVoltage}, 2);
+    buffer += ',';
+    appendJsonArray(buffer, 't', {livestats.frontTemperature, livestats.backTemperature}, 1);
+    buffer += ',';
+    appendJsonArray(buffer, 'e', {double(livestats.frontLeftError), double(livestats.frontRightError),
+                                  double(livestats.backLeftError), double(livestats.backRightError)}, 0);
+    buffer += ',';
+    appendJsonArray(buffer, 's', {livestats.frontLeftSpeed, livestats.frontRightSpeed,
+                                  livestats.backLeftSpeed, livestats.backRightSpeed}, 2);
+    buffer += ',';
+    appendJsonArray(buffer, 'a', {livestats.frontLeftDcLink, livestats.frontRightDcLink,
+                                  livestats.backLeftDcLink, livestats.backRightDcLink}, 2);
+    buffer += '}';
+}
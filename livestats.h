@@ -0,0 +1,69 @@
+#pragma once
+
+// system includes
+#include <cstdint>
+
+// Qt includes
+#include <QByteArray>
+#include <QString>
+
+struct Livestats
+{
+    float frontVoltage{};
+    float backVoltage{};
+    float frontTemperature{};
+    float backTemperature{};
+    int frontLeftError{};
+    int frontRightError{};
+    int backLeftError{};
+    int backRightError{};
+    float frontLeftSpeed{};
+    float frontRightSpeed{};
+    float backLeftSpeed{};
+    float backRightSpeed{};
+    float frontLeftDcLink{};
+    float frontRightDcLink{};
+    float backLeftDcLink{};
+    float backRightDcLink{};
+};
+
+enum class LivestatsFormat
+{
+    Unknown,
+    Json,
+    BinaryV1,
+    // part of a record, see LivestatsReassembler
+    Fragment
+};
+
+// Binary livestats frame, version 1 (29 bytes, little endian):
+//   u8  version             0x01
+//   i16 voltage[2]          front, back        (1/100 V)
+//   i16 temperature[2]      front, back        (1/10 °C)
+//   u8  error[4]            fl, fr, bl, br
+//   i16 speed[4]            fl, fr, bl, br     (1/100 km/h)
+//   i16 dcLink[4]           fl, fr, bl, br     (1/100 A)
+//
+// The version byte is always below 0x20, so it can never be confused with the
+// first character of a JSON document from older firmware.
+constexpr uint8_t livestatsBinaryVersion1 = 0x01;
+constexpr int livestatsBinaryV1Size = 29;
+
+// Fragmented livestats record, for records that do not fit into a single
+// notification at the negotiated MTU:
+//   u8  marker              0x02
+//   u8  record              sequence number of the record, wraps around
+//   u8  fragment            bit 7: last fragment, bits 0..6: fragment index
+//   u8  payload[]           next part of a JSON or binary livestats record
+constexpr uint8_t livestatsFragmentMarker = 0x02;
+constexpr int livestatsFragmentHeaderSize = 3;
+constexpr uint8_t livestatsLastFragment = 0x80;
+
+LivestatsFormat detectLivestatsFormat(const QByteArray &value);
+
+bool parseLivestatsBinary(const QByteArray &value, Livestats &livestats, QString &errorString);
+bool parseLivestatsJson(const QByteArray &value, Livestats &livestats, QString &errorString);
+
+// firmware side of the formats, used by SimulatedTransport
+void encodeLivestatsBinary(QByteArray &buffer, const Livestats &livestats);
+void encodeLivestatsJson(QByteArray &buffer, const Livestats &livestats);
@@ -0,0 +1,93 @@
+#include "livestatsreassembler.h"
+
+// local includes
+#include "livestats.h"
+
+LivestatsReassembler::LivestatsReassembler()
+{
+    // with the capacity reserved, resize(0) keeps the buffer
+    m_record.reserve(maxRecordSize);
+}
+
+LivestatsReassembler::Result LivestatsReassembler::append(const QByteArray &fragment, qint64 now)
+{
+    if (fragment.size() < livestatsFragmentHeaderSize || uint8_t(fragment.at(0)) != livestatsFragmentMarker)
+    {
+        if (!m_pending)
+            m_discarded++;
+        discard();
+        return Result::Discarded;
+    }
+
+    const auto sequence = uint8_t(fragment.at(1));
+    const auto flags = uint8_t(fragment.at(2));
+    const int index = flags & ~livestatsLastFragment;
+    const bool last = flags & livestatsLastFragment;
+
+    bool discarded{};
+    if (m_pending && (sequence != m_sequence || index != m_nextIndex || now - m_started > m_timeout))
+    {
+        // the rest of the pending record got lost
+        discard();
+        discarded = true;
+    }
+
+    if (!m_pending)
+    {
+        if (index != 0)
+        {
+            // the start of this record got lost, ignore the rest of it
+            if (!discarded)
+                m_discarded++;
+            return Result::Discarded;
+        }
+
+        m_record.resize(0);
+        m_pending = true;
+        m_sequence = sequence;
+        m_nextIndex = 0;
+        m_started = now;
+    }
+
+    const int payloadSize = fragment.size() - livestatsFragmentHeaderSize;
+    if (m_record.size() + payloadSize > maxRecordSize)
+    {
+        discard();
+        return Result::Discarded;
+    }
+
+    m_record.append(fragment.constData() + livestatsFragmentHeaderSize, payloadSize);
+    m_nextIndex++;
+
+    if (last)
+    {
+        m_pending = false;
+        return Result::Complete;
+    }
+
+    return discarded ? Result::Discarded : Result::Incomplete;
+}
+
+bool LivestatsReassembler::expire(qint64 now)
+{
+    if (!m_pending || now - m_started <= m_timeout)
+        return false;
+
+    discard();
+    return true;
+}
+
+void LivestatsReassembler::reset()
+{
+    m_pending = false;
+    m_record.resize(0);
+}
+
+void LivestatsReassembler::discard()
+{
+    if (m_pending)
+        m_discarded++;
+
+    m_pending = false;
+    m_record.resize(0);
+}
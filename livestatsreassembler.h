@@ -0,0 +1,57 @@
+#pragma once
+
+// Qt includes
+#include <QByteArray>
+#include <QtGlobal>
+
+// Collects livestats fragments (see livestatsFragmentMarker) into complete
+// records. The record buffer is allocated once, fragments are appended in
+// place. A record is discarded when a fragment is missing, arrives out of
+// order, the record grows beyond maxRecordSize or does not complete within
+// timeout().
+class LivestatsReassembler
+{
+public:
+    static constexpr int maxRecordSize = 4096;
+
+    enum class Result
+    {
+        // more fragments needed
+        Incomplete,
+        // record() holds a complete record
+        Complete,
+        // the fragment or a previously started record was dropped
+        Discarded
+    };
+
+    LivestatsReassembler();
+
+    // milliseconds a record may take from its first to its last fragment
+    int timeout() const { return m_timeout; }
+    void setTimeout(int timeout) { m_timeout = timeout; }
+
+    Result append(const QByteArray &fragment, qint64 now);
+
+    // valid until the next append() after Complete
+    const QByteArray &record() const { return m_record; }
+
+    bool pending() const { return m_pending; }
+    // discards a pending record that timed out, true if one was discarded
+    bool expire(qint64 now);
+
+    // records discarded so far
+    int discarded() const { return m_discarded; }
+
+    void reset();
+
+private:
+    void discard();
+
+    QByteArray m_record;
+    bool m_pending{};
+    uint8_t m_sequence{};
+    int m_nextIndex{};
+    qint64 m_started{};
+    int m_timeout{500};
+    int m_discarded{};
+};
@@ -2,25 +2,67 @@
 #include <QLoggingCategory>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QCommandLineParser>
 
 #include "connectionhandler.h"
 #include "devicefinder.h"
 #include "devicehandler.h"
+#include "fleetmanager.h"
+#include "simulatedtransport.h"
 
 int main(int argc, char *argv[])
 {
     //QLoggingCategory::setFilterRules(QStringLiteral("qt.bluetooth* = true"));
+    // hot path text tracing of debug builds, e.g. QT_LOGGING_RULES="bobbycar.control.debug=true"
+    //QLoggingCategory::setFilterRules(QStringLiteral("bobbycar.*.debug = true"));
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QGuiApplication app(argc, argv);
+    // QSettings and the app data location are keyed by these
+    QGuiApplication::setOrganizationName(QStringLiteral("bobbycar-graz"));
+    QGuiApplication::setApplicationName(QStringLiteral("bobbycar-app"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption simulateOption{QStringLiteral("simulate"), QStringLiteral("Talk to a simulated bobbycar instead of using Bluetooth.")};
+    const QCommandLineOption rateOption{QStringLiteral("simulate-rate"), QStringLiteral("Simulated livestats notifications per second."), QStringLiteral("hz"), QStringLiteral("10")};
+    const QCommandLineOption formatOption{QStringLiteral("simulate-format"), QStringLiteral("Simulated livestats format (json or binary)."), QStringLiteral("format"), QStringLiteral("json")};
+    const QCommandLineOption latencyOption{QStringLiteral("simulate-latency"), QStringLiteral("Simulated write latency in milliseconds."), QStringLiteral("ms"), QStringLiteral("10")};
+    const QCommandLineOption lossOption{QStringLiteral("simulate-loss"), QStringLiteral("Simulated probability (0..1) that a write is lost."), QStringLiteral("rate"), QStringLiteral("0")};
+    const QCommandLineOption mtuOption{QStringLiteral("simulate-mtu"), QStringLiteral("Simulated negotiated MTU, larger livestats are fragmented."), QStringLiteral("bytes"), QStringLiteral("185")};
+    const QCommandLineOption traceOption{QStringLiteral("trace"), QStringLiteral("Record hot path events into the in-memory trace ring, dumped on errors.")};
+    parser.addOptions({simulateOption, rateOption, formatOption, latencyOption, lossOption, mtuOption, traceOption});
+    parser.process(app);
 
     ConnectionHandler connectionHandler;
     DeviceHandler deviceHandler;
+    FleetManager fleetManager;
+
+    deviceHandler.setTracing(parser.isSet(traceOption));
+
+    if (parser.isSet(simulateOption))
+    {
+        const auto createTransport = [&parser, rateOption, formatOption, latencyOption, lossOption, mtuOption]() -> BobbycarTransport * {
+            auto transport = new SimulatedTransport;
+            transport->setLivestatsRate(parser.value(rateOption).toInt());
+            transport->setLivestatsFormat(parser.value(formatOption) == QLatin1String("binary") ? LivestatsFormat::BinaryV1 : LivestatsFormat::Json);
+            transport->setWriteLatency(parser.value(latencyOption).toInt());
+            transport->setAcknowledgeLatency(parser.value(latencyOption).toInt());
+            transport->setWriteLossRate(parser.value(lossOption).toDouble());
+            transport->setNegotiatedMtu(parser.value(mtuOption).toInt());
+            return transport;
+        };
+
+        deviceHandler.setTransport(createTransport());
+        fleetManager.setTransportFactory(createTransport);
+        fleetManager.finder()->setSimulatedDevices(5);
+    }
 
     qmlRegisterUncreatableType<DeviceHandler>("Shared", 1, 0, "AddressType", "Enum is not a type");
 
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextProperty("connectionHandler", &connectionHandler);
     engine.rootContext()->setContextProperty("deviceHandler", &deviceHandler);
+    engine.rootContext()->setContextProperty("fleetManager", &fleetManager);
 
     engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
 
@@ -53,6 +53,7 @@ Item {
             if (status === Loader.Ready)
             {
                 pageLoader.item.init();
+                deviceHandler.livedataVisible = pageLoader.item.showsLivedata === true
                 pageLoader.item.forceActiveFocus()
             }
         }
@@ -8,6 +8,20 @@ GamePage {
         handler: deviceHandler
     }
 
+    // cars for the fleet are picked from the same scan
+    Binding {
+        target: fleetManager
+        property: "finder"
+        value: deviceFinder
+    }
+
+    Connections {
+        target: deviceFinder
+        function onAutoConnecting() {
+            app.showPage("Livedata.qml")
+        }
+    }
+
     function init() {
         deviceFinder.startSearch()
     }
@@ -18,7 +32,7 @@ GamePage {
     Rectangle {
         id: viewContainer
         anchors.top: parent.top
-        anchors.bottom:
+        anchors.bottom: fleetContainer.visible ? fleetContainer.top :
             // only BlueZ platform has address type selection
             connectionHandler.requiresAddressType ? addressTypeButton.top : searchButton.top
         anchors.topMargin: GameSettings.fieldMargin + messageHeight
@@ -65,9 +79,11 @@ GamePage {
                 MouseArea {
                 anchors.fill: parent
                     onClicked: {
-                        deviceFinder.connectToService(deviceAddress);
+                        deviceFinder.connectToService(deviceId);
                         app.showPage("Livedata.qml")
                     }
+                    // keeps connected next to the car shown on the other pages
+                    onPressAndHold: fleetManager.addCar(deviceId)
                 }
 
                 Text {
@@ -91,6 +107,87 @@ GamePage {
                     anchors.right: parent.right
                     color: Qt.darker(GameSettings.textColor)
                 }
+
+                Text {
+                    font.pixelSize: GameSettings.smallFontSize
+                    text: rssi + " dBm"
+                    visible: rssi !== 0
+                    anchors.bottom: parent.bottom
+                    anchors.bottomMargin: parent.height * 0.1
+                    anchors.leftMargin: parent.height * 0.1
+                    anchors.left: parent.left
+                    color: Qt.darker(GameSettings.textColor)
+                }
+            }
+        }
+    }
+
+    Rectangle {
+        id: fleetContainer
+        anchors.bottom:
+            connectionHandler.requiresAddressType ? addressTypeButton.top : searchButton.top
+        anchors.bottomMargin: GameSettings.fieldMargin
+        anchors.horizontalCenter: parent.horizontalCenter
+        width: viewContainer.width
+        height: GameSettings.fieldHeight * (1 + Math.min(fleetManager.count, 3) * 0.8)
+        visible: fleetManager.count > 0
+        color: GameSettings.viewColor
+        radius: GameSettings.buttonRadius
+
+        Text {
+            id: fleetTitle
+            width: parent.width
+            height: GameSettings.fieldHeight
+            horizontalAlignment: Text.AlignHCenter
+            verticalAlignment: Text.AlignVCenter
+            color: GameSettings.textColor
+            font.pixelSize: GameSettings.mediumFontSize
+            text: qsTr("FLEET")
+
+            BottomLine {
+                height: 1;
+                width: parent.width
+                color: "#898989"
+            }
+        }
+
+        ListView {
+            anchors.left: parent.left
+            anchors.right: parent.right
+            anchors.bottom: parent.bottom
+            anchors.top: fleetTitle.bottom
+            model: fleetManager
+            clip: true
+
+            delegate: Rectangle {
+                height: GameSettings.fieldHeight * 0.8
+                width: parent.width
+                color: index % 2 === 0 ? GameSettings.delegate1Color : GameSettings.delegate2Color
+
+                MouseArea {
+                    anchors.fill: parent
+                    onPressAndHold: fleetManager.removeCar(index)
+                }
+
+                Text {
+                    font.pixelSize: GameSettings.smallFontSize
+                    text: name
+                    anchors.verticalCenter: parent.verticalCenter
+                    anchors.leftMargin: parent.height * 0.1
+                    anchors.left: parent.left
+                    color: alive ? GameSettings.textColor : GameSettings.disabledTextColor
+                }
+
+                Text {
+                    font.pixelSize: GameSettings.smallFontSize
+                    text: alive ? ((telemetry.frontLeftSpeed + telemetry.frontRightSpeed +
+                                    telemetry.backLeftSpeed + telemetry.backRightSpeed) / 4).toFixed(1) + " km/h"
+                                : (error !== "" ? error : info)
+                    anchors.verticalCenter: parent.verticalCenter
+                    anchors.rightMargin: parent.height * 0.1
+                    anchors.right: parent.right
+                    color: Qt.darker(GameSettings.textColor)
+                }
             }
         }
     }
@@ -9,6 +9,8 @@ Item {
     property real messageHeight: msg.height
     property bool hasError: errorMessage != ""
     property bool hasInfo: infoMessage != ""
+    // keeps the link on the balanced connection profile while shown
+    property bool showsLivedata: false
 
     function init()
     {
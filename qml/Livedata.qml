@@ -1,16 +1,16 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import bobbycar 1.0
 
 GamePage {
     id: livedatePage
 
     errorMessage: deviceHandler.error
     infoMessage: deviceHandler.info
+    showsLivedata: true
 
-    property real avgSpeed: (deviceHandler.frontLeftSpeed + deviceHandler.frontRightSpeed + deviceHandler.backLeftSpeed + deviceHandler.backRightSpeed) / 4
-    property real avgVoltage: (deviceHandler.frontVoltage + deviceHandler.backVoltage) / 2
-    property real totalCurrent: deviceHandler.frontLeftDcLink + deviceHandler.frontRightDcLink + deviceHandler.backLeftDcLink + deviceHandler.backRightDcLink
-    property real totalPower: totalCurrent * avgVoltage
+    // aggregated in C++ once per packet
+    readonly property var metrics: deviceHandler.metrics
 
     function close()
     {
@@ -46,21 +46,75 @@ GamePage {
                     anchors.horizontalCenter: parent.horizontalCenter
                     font.pixelSize: GameSettings.hugeFontSize * 2
                     color: GameSettings.textColor
-                    text: Number(avgSpeed).toLocaleString(Qt.locale()) + 'km/h'
+                    text: Number(metrics.avgSpeed).toLocaleString(Qt.locale()) + 'km/h'
                 }
 
                 Text {
                     anchors.horizontalCenter: parent.horizontalCenter
                     font.pixelSize: GameSettings.hugeFontSize * 2
                     color: GameSettings.textColor
-                    text: Number(totalCurrent).toLocaleString(Qt.locale()) + 'A'
+                    text: Number(metrics.totalCurrent).toLocaleString(Qt.locale()) + 'A'
                 }
 
                 Text {
                     anchors.horizontalCenter: parent.horizontalCenter
                     font.pixelSize: GameSettings.hugeFontSize * 2
                     color: GameSettings.textColor
-                    text: Number(totalPower>1000?(totalPower/1000):totalPower).toLocaleString(Qt.locale()) + (totalPower > 1000 ? "kW" : "W")
+                    text: Number(metrics.totalPower>1000?(metrics.totalPower/1000):metrics.totalPower).toLocaleString(Qt.locale()) + (metrics.totalPower > 1000 ? "kW" : "W")
+                }
+
+                Text {
+                    anchors.horizontalCenter: parent.horizontalCenter
+                    horizontalAlignment: Text.AlignHCenter
+                    wrapMode: Text.WordWrap
+                    text: "Trip: " + Number(metrics.tripDistance).toLocaleString(Qt.locale(), 'f', 2) + "km / "
+                          + Number(metrics.energyConsumed - metrics.energyRegenerated).toLocaleString(Qt.locale(), 'f', 1) + "Wh / "
+                          + Number(metrics.energyPerKm).toLocaleString(Qt.locale(), 'f', 1) + "Wh/km\n"
+                          + "Regenerated: " + Number(metrics.energyRegenerated).toLocaleString(Qt.locale(), 'f', 1) + "Wh, peak: "
+                          + Number(metrics.peakPower).toLocaleString(Qt.locale(), 'f', 0) + "W"
+                    color: GameSettings.textColor
+                    font.pixelSize: GameSettings.mediumFontSize
+
+                    // long press starts a new trip
+                    MouseArea {
+                        anchors.fill: parent
+                        onPressAndHold: deviceHandler.resetTrip()
+                    }
+                }
+
+                // last minute of history, rendered in C++
+                Repeater {
+                    model: [
+                        { title: "Speed", channels: ["frontLeftSpeed", "frontRightSpeed", "backLeftSpeed", "backRightSpeed"] },
+                        { title: "Current", channels: ["frontLeftDcLink", "frontRightDcLink", "backLeftDcLink", "backRightDcLink"] },
+                        { title: "Temperature", channels: ["frontTemperature", "backTemperature"] }
+                    ]
+
+                    Rectangle {
+                        width: container.width - 10
+                        height: GameSettings.fieldHeight * 2
+                        color: GameSettings.delegate1Color
+
+                        TelemetryChart {
+                            id: chart
+                            anchors.fill: parent
+                            anchors.margins: 2
+                            clip: true
+                            handler: deviceHandler
+                            channels: modelData.channels
+                            duration: 60000
+                        }
+
+                        Text {
+                            anchors.left: parent.left
+                            anchors.top: parent.top
+                            anchors.margins: 4
+                            text: modelData.title + ": " + Number(chart.minimum).toLocaleString(Qt.locale(), 'f', 1)
+                                  + " .. " + Number(chart.maximum).toLocaleString(Qt.locale(), 'f', 1)
+                            color: GameSettings.textColor
+                            font.pixelSize: GameSettings.tinyFontSize
+                        }
+                    }
                 }
 
                 Text {
@@ -136,7 +190,8 @@ GamePage {
                     }
 
                     SpinBox {
-                        value: 50
+                        value: deviceHandler.carSettings.current.iMotMax ?? 50
+                        onValueModified: deviceHandler.carSettings.set("iMotMax", value)
                     }
                 }
 
@@ -150,9 +205,17 @@ GamePage {
                     }
 
                     SpinBox {
-                        value: 50
+                        value: deviceHandler.carSettings.current.iDcMax ?? 50
+                        onValueModified: deviceHandler.carSettings.set("iDcMax", value)
                     }
                 }
+
+                // all staged settings go out as one transaction
+                Button {
+                    text: deviceHandler.carSettings.busy ? qsTr("Applying...") : qsTr("Apply")
+                    enabled: !deviceHandler.carSettings.busy && Object.keys(deviceHandler.carSettings.pending).length > 0
+                    onClicked: deviceHandler.carSettings.apply()
+                }
             }
         }
     }
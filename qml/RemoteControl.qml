@@ -1,16 +1,25 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import bobbycar 1.0
 
 GamePage {
     id: remoteControlPage
 
     errorMessage: deviceHandler.error
     infoMessage: deviceHandler.info
-
-    property real avgSpeed: (deviceHandler.frontLeftSpeed + deviceHandler.frontRightSpeed + deviceHandler.backLeftSpeed + deviceHandler.backRightSpeed) / 4
-    property real avgVoltage: (deviceHandler.frontVoltage + deviceHandler.backVoltage) / 2
-    property real totalCurrent: deviceHandler.frontLeftDcLink + deviceHandler.frontRightDcLink + deviceHandler.backLeftDcLink + deviceHandler.backRightDcLink
-    property real totalPower: totalCurrent * avgVoltage
+    showsLivedata: true
+
+    // aggregated in C++ once per packet
+    readonly property var metrics: deviceHandler.metrics
+
+    RemoteControlMixer {
+        id: mixer
+        handler: deviceHandler
+        frontLeftRight: frontLeftRightSpinbox.value
+        frontUpDown: frontUpDownSpinbox.value
+        backLeftRight: backLeftRightSpinbox.value
+        backUpDown: backUpDownSpinbox.value
+    }
 
     Column {
         anchors.centerIn: parent
@@ -23,25 +32,25 @@ GamePage {
             Text {
                 font.pixelSize: GameSettings.hugeFontSize
                 color: GameSettings.textColor
-                text: Number(avgSpeed).toLocaleString(Qt.locale()) + 'km/h'
+                text: Number(metrics.avgSpeed).toLocaleString(Qt.locale()) + 'km/h'
             }
 
             Text {
                 font.pixelSize: GameSettings.hugeFontSize
                 color: GameSettings.textColor
-                text: Number(totalCurrent).toLocaleString(Qt.locale()) + 'A'
+                text: Number(metrics.totalCurrent).toLocaleString(Qt.locale()) + 'A'
             }
 
             Text {
                 font.pixelSize: GameSettings.hugeFontSize
                 color: GameSettings.textColor
-                text: Number(totalPower>1000?(totalPower/1000):totalPower).toLocaleString(Qt.locale()) + (totalPower > 1000 ? "kW" : "W")
+                text: Number(metrics.totalPower>1000?(metrics.totalPower/1000):metrics.totalPower).toLocaleString(Qt.locale()) + (metrics.totalPower > 1000 ? "kW" : "W")
             }
 
             Text {
                 font.pixelSize: GameSettings.hugeFontSize
                 color: GameSettings.textColor
-                text: Number(avgVoltage).toLocaleString(Qt.locale()) + 'V'
+                text: Number(metrics.avgVoltage).toLocaleString(Qt.locale()) + 'V'
             }
         }
 
@@ -52,15 +61,9 @@ GamePage {
             radius: GameSettings.buttonRadius
             color: GameSettings.viewColor
 
-            property real remoteControlFrontLeft: (handler.relativeX * frontLeftRightSpinbox.value) + (handler.relativeY * frontUpDownSpinbox.value)
-            property real remoteControlFrontRight: (-handler.relativeX * frontLeftRightSpinbox.value) + (handler.relativeY * frontUpDownSpinbox.value)
-            property real remoteControlBackLeft: (handler.relativeX * backLeftRightSpinbox.value) + (handler.relativeY * backUpDownSpinbox.value)
-            property real remoteControlBackRight: (-handler.relativeX * backLeftRightSpinbox.value) + (handler.relativeY * backUpDownSpinbox.value)
-
-            onRemoteControlFrontLeftChanged: deviceHandler.remoteControlFrontLeft = remoteControlFrontLeft
-            onRemoteControlFrontRightChanged: deviceHandler.remoteControlFrontRight = remoteControlFrontRight
-            onRemoteControlBackLeftChanged: deviceHandler.remoteControlBackLeft = remoteControlBackLeft
-            onRemoteControlBackRightChanged: deviceHandler.remoteControlBackRight = remoteControlBackRight
+            // the mixer computes all four wheels in C++ and hands them over in one go
+            property point input: Qt.point(handler.relativeX, handler.relativeY)
+            onInputChanged: mixer.setInput(input.x, input.y)
 
             Rectangle {
                 parent: container
@@ -80,8 +83,8 @@ GamePage {
                 color: GameSettings.textColor
                 text: {
                     return "x:" + handler.relativeX.toFixed(1) + " y:" + handler.relativeY.toFixed(1) + "\n" +
-                           "fl:" + Math.round(container.remoteControlFrontLeft) + " fr:" + Math.round(container.remoteControlFrontRight) + "\n" +
-                           "bl:" + Math.round(container.remoteControlBackLeft) + " br:" + Math.round(container.remoteControlBackRight);
+                           "fl:" + mixer.frontLeft + " fr:" + mixer.frontRight + "\n" +
+                           "bl:" + mixer.backLeft + " br:" + mixer.backRight;
                 }
             }
 
@@ -1,6 +1,7 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
 import Shared 1.0
+import bobbycar 1.0
 
 GamePage {
     id: livedatePage
@@ -8,6 +9,16 @@ GamePage {
     errorMessage: deviceHandler.error
     infoMessage: deviceHandler.info
 
+    WifiListModel {
+        id: wifiList
+        handler: deviceHandler
+    }
+
+    function init()
+    {
+        wifiList.refresh()
+    }
+
     function close()
     {
         deviceHandler.disconnectService();
@@ -33,7 +44,14 @@ GamePage {
             verticalAlignment: Text.AlignVCenter
             color: GameSettings.textColor
             font.pixelSize: GameSettings.mediumFontSize
-            text: qsTr("WIFIS")
+            text: wifiList.scanning ? qsTr("WIFIS (scanning...)") : qsTr("WIFIS")
+
+            // rows arrive while the car is still scanning
+            MouseArea {
+                anchors.fill: parent
+                enabled: !wifiList.scanning
+                onClicked: wifiList.refresh()
+            }
 
             BottomLine {
                 height: 1;
@@ -49,7 +67,7 @@ GamePage {
             anchors.right: parent.right
             anchors.bottom: parent.bottom
             anchors.top: title.bottom
-            //model: deviceFinder.devices // Needs to be changed
+            model: wifiList
             clip: true
 
             delegate: Rectangle {
@@ -68,24 +86,33 @@ GamePage {
                 Text {
                     id: device
                     font.pixelSize: GameSettings.smallFontSize
-                    text: modelData.ssid
+                    text: ssid
                     anchors.top: parent.top
                     anchors.topMargin: parent.height * 0.1
                     anchors.leftMargin: parent.height * 0.1
                     anchors.left: parent.left
                     color: GameSettings.textColor
                 }
-/*
+
                 Text {
                     id: deviceAddress
                     font.pixelSize: GameSettings.smallFontSize
-                    text: modelData.deviceAddress
+                    text: bssid + " / ch " + channel + (encryption === 0 ? " / open" : "")
                     anchors.bottom: parent.bottom
                     anchors.bottomMargin: parent.height * 0.1
+                    anchors.leftMargin: parent.height * 0.1
+                    anchors.left: parent.left
+                    color: Qt.darker(GameSettings.textColor)
+                }
+
+                Text {
+                    font.pixelSize: GameSettings.smallFontSize
+                    text: rssi + " dBm"
+                    anchors.verticalCenter: parent.verticalCenter
                     anchors.rightMargin: parent.height * 0.1
                     anchors.right: parent.right
-                    color: Qt.darker(GameSettings.textColor)
-                }*/
+                    color: GameSettings.textColor
+                }
             }
         }
     }
@@ -0,0 +1,88 @@
+#include "remotecontrolframe.h"
+
+// system includes
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+// Qt includes
+#include <QtEndian>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+qint16 clampSetpoint(int value)
+{
+    return qint16(std::clamp<int>(value, std::numeric_limits<qint16>::min(), std::numeric_limits<qint16>::max()));
+}
+}
+
+void encodeRemoteControlBinary(QByteArray &buffer, uint8_t sequence, const RemoteControlSetpoints &setpoints)
+{
+    if (buffer.size() != remoteControlBinaryV1Size)
+        buffer.resize(remoteControlBinaryV1Size);
+
+    char *ptr = buffer.data();
+
+    ptr[0] = char(remoteControlBinaryVersion1);
+    ptr[1] = char(sequence);
+    qToLittleEndian<qint16>(clampSetpoint(setpoints.frontLeft), ptr + 2);
+    qToLittleEndian<qint16>(clampSetpoint(setpoints.frontRight), ptr + 4);
+    qToLittleEndian<qint16>(clampSetpoint(setpoints.backLeft), ptr + 6);
+    qToLittleEndian<qint16>(clampSetpoint(setpoints.backRight), ptr + 8);
+
+    uint8_t checksum{};
+    for (int i = 0; i < remoteControlBinaryV1Size - 1; ++i)
+        checksum ^= uint8_t(ptr[i]);
+    ptr[remoteControlBinaryV1Size - 1] = char(checksum);
+}
+
+void encodeRemoteControlJson(QByteArray &buffer, const RemoteControlSetpoints &setpoints)
+{
+    if (buffer.capacity() < remoteControlFrameCapacity)
+        buffer.reserve(remoteControlFrameCapacity);
+    buffer.resize(remoteControlFrameCapacity);
+
+    // same key order and layout as QJsonDocument::Compact produced before
+    const int length = std::snprintf(buffer.data(), remoteControlFrameCapacity,
+                                     "{\"bl\":%d,\"br\":%d,\"fl\":%d,\"fr\":%d}",
+                                     setpoints.backLeft, setpoints.backRight,
+                                     setpoints.frontLeft, setpoints.frontRight);
+
+    buffer.resize(std::clamp(length, 0, remoteControlFrameCapacity - 1));
+}
+
+bool decodeRemoteControl(const QByteArray &frame, RemoteControlSetpoints &setpoints)
+{
+    if (!frame.isEmpty() && uint8_t(frame.at(0)) == remoteControlBinaryVersion1)
+    {
+        if (frame.size() < remoteControlBinaryV1Size)
+            return false;
+
+        const char *ptr = frame.constData();
+
+        uint8_t checksum{};
+        for (int i = 0; i < remoteControlBinaryV1Size - 1; ++i)
+            checksum ^= uint8_t(ptr[i]);
+        if (checksum != uint8_t(ptr[remoteControlBinaryV1Size - 1]))
+            return false;
+
+        setpoints.frontLeft = qFromLittleEndian<qint16>(ptr + 2);
+        setpoints.frontRight = qFromLittleEndian<qint16>(ptr + 4);
+        setpoints.backLeft = qFromLittleEndian<qint16>(ptr + 6);
+        setpoints.backRight = qFromLittleEndian<qint16>(ptr + 8);
+        return true;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(frame, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject())
+        return false;
+
+    const QJsonObject obj = doc.object();
+    setpoints.frontLeft = obj.value("fl").toInt();
+    setpoints.frontRight = obj.value("fr").toInt();
+    setpoints.backLeft = obj.value("bl").toInt();
+    setpoints.backRight = obj.value("br").toInt();
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// system includes
+#include <cstdint>
+
+// Qt includes
+#include <QByteArray>
+
+struct RemoteControlSetpoints
+{
+    int frontLeft{};
+    int frontRight{};
+    int backLeft{};
+    int backRight{};
+};
+
+// Binary remote control frame, version 1 (11 bytes, little endian):
+//   u8  version             0x01
+//   u8  sequence            incremented for every frame sent
+//   i16 setpoint[4]         fl, fr, bl, br
+//   u8  checksum            XOR over all preceding bytes
+//
+// Firmware that streams binary livestats also accepts this frame, everything
+// else gets the JSON encoding ({"bl":..,"br":..,"fl":..,"fr":..}).
+constexpr uint8_t remoteControlBinaryVersion1 = 0x01;
+constexpr int remoteControlBinaryV1Size = 11;
+
+// large enough for either encoding with any int setpoints
+constexpr int remoteControlFrameCapacity = 64;
+// longest JSON frame the encoder produces
+constexpr int remoteControlJsonMaxSize = remoteControlFrameCapacity - 1;
+
+// Both encoders write into the passed buffer and only resize it when it is
+// too small, so a reused buffer does not allocate on the control path.
+void encodeRemoteControlBinary(QByteArray &buffer, uint8_t sequence, const RemoteControlSetpoints &setpoints);
+void encodeRemoteControlJson(QByteArray &buffer, const RemoteControlSetpoints &setpoints);
+
+// car side of the formats, accepts both encodings
+bool decodeRemoteControl(const QByteArray &frame, RemoteControlSetpoints &setpoints);
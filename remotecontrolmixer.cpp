@@ -0,0 +1,107 @@
+#include "remotecontrolmixer.h"
+
+// local includes
+#include "devicehandler.h"
+
+RemoteControlMixer::RemoteControlMixer(QObject *parent) :
+    QObject{parent}
+{
+}
+
+void RemoteControlMixer::setHandler(DeviceHandler *handler)
+{
+    if (m_handler == handler)
+        return;
+
+    if (m_handler)
+        m_handler->disconnect(this);
+
+    m_handler = handler;
+
+    if (m_handler)
+    {
+        // the worker starts from zero setpoints whenever remote control is
+        // switched on again, mix() only sends changes
+        connect(m_handler, &DeviceHandler::remoteControlActiveChanged, this, [this]() {
+            if (m_handler->remoteControlActive())
+                sendOutput();
+        });
+        sendOutput();
+    }
+
+    emit handlerChanged();
+}
+
+void RemoteControlMixer::setFrontLeftRight(int frontLeftRight)
+{
+    if (m_frontLeftRight == frontLeftRight)
+        return;
+
+    m_frontLeftRight = frontLeftRight;
+    emit gainsChanged();
+    mix();
+}
+
+void RemoteControlMixer::setFrontUpDown(int frontUpDown)
+{
+    if (m_frontUpDown == frontUpDown)
+        return;
+
+    m_frontUpDown = frontUpDown;
+    emit gainsChanged();
+    mix();
+}
+
+void RemoteControlMixer::setBackLeftRight(int backLeftRight)
+{
+    if (m_backLeftRight == backLeftRight)
+        return;
+
+    m_backLeftRight = backLeftRight;
+    emit gainsChanged();
+    mix();
+}
+
+void RemoteControlMixer::setBackUpDown(int backUpDown)
+{
+    if (m_backUpDown == backUpDown)
+        return;
+
+    m_backUpDown = backUpDown;
+    emit gainsChanged();
+    mix();
+}
+
+void RemoteControlMixer::setInput(qreal x, qreal y)
+{
+    m_x = qBound<qreal>(-1., x, 1.);
+    m_y = qBound<qreal>(-1., y, 1.);
+    mix();
+}
+
+void RemoteControlMixer::mix()
+{
+    const int frontLeft = qRound((m_x * m_frontLeftRight) + (m_y * m_frontUpDown));
+    const int frontRight = qRound((-m_x * m_frontLeftRight) + (m_y * m_frontUpDown));
+    const int backLeft = qRound((m_x * m_backLeftRight) + (m_y * m_backUpDown));
+    const int backRight = qRound((-m_x * m_backLeftRight) + (m_y * m_backUpDown));
+
+    const bool changed = frontLeft != m_frontLeft || frontRight != m_frontRight ||
+                         backLeft != m_backLeft || backRight != m_backRight;
+
+    m_frontLeft = frontLeft;
+    m_frontRight = frontRight;
+    m_backLeft = backLeft;
+    m_backRight = backRight;
+
+    emit outputChanged();
+
+    if (changed)
+        sendOutput();
+}
+
+void RemoteControlMixer::sendOutput()
+{
+    if (m_handler)
+        m_handler->setRemoteControl(m_frontLeft, m_frontRight, m_backLeft, m_backRight);
+}
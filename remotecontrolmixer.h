@@ -0,0 +1,75 @@
+#pragma once
+
+// Qt includes
+#include <QObject>
+#include <QtQml/qqml.h>
+
+// forward declares
+class DeviceHandler;
+
+class RemoteControlMixer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(DeviceHandler* handler READ handler WRITE setHandler NOTIFY handlerChanged)
+    Q_PROPERTY(int frontLeftRight READ frontLeftRight WRITE setFrontLeftRight NOTIFY gainsChanged)
+    Q_PROPERTY(int frontUpDown READ frontUpDown WRITE setFrontUpDown NOTIFY gainsChanged)
+    Q_PROPERTY(int backLeftRight READ backLeftRight WRITE setBackLeftRight NOTIFY gainsChanged)
+    Q_PROPERTY(int backUpDown READ backUpDown WRITE setBackUpDown NOTIFY gainsChanged)
+    Q_PROPERTY(qreal x READ x NOTIFY outputChanged)
+    Q_PROPERTY(qreal y READ y NOTIFY outputChanged)
+    Q_PROPERTY(int frontLeft READ frontLeft NOTIFY outputChanged)
+    Q_PROPERTY(int frontRight READ frontRight NOTIFY outputChanged)
+    Q_PROPERTY(int backLeft READ backLeft NOTIFY outputChanged)
+    Q_PROPERTY(int backRight READ backRight NOTIFY outputChanged)
+    QML_ELEMENT
+
+public:
+    explicit RemoteControlMixer(QObject *parent = nullptr);
+
+    DeviceHandler* handler() { return m_handler; }
+    const DeviceHandler* handler() const { return m_handler; }
+    void setHandler(DeviceHandler* handler);
+
+    int frontLeftRight() const { return m_frontLeftRight; }
+    void setFrontLeftRight(int frontLeftRight);
+    int frontUpDown() const { return m_frontUpDown; }
+    void setFrontUpDown(int frontUpDown);
+    int backLeftRight() const { return m_backLeftRight; }
+    void setBackLeftRight(int backLeftRight);
+    int backUpDown() const { return m_backUpDown; }
+    void setBackUpDown(int backUpDown);
+
+    qreal x() const { return m_x; }
+    qreal y() const { return m_y; }
+    int frontLeft() const { return m_frontLeft; }
+    int frontRight() const { return m_frontRight; }
+    int backLeft() const { return m_backLeft; }
+    int backRight() const { return m_backRight; }
+
+    // x and y are normalized to -1..1, positive y drives forward
+    Q_INVOKABLE void setInput(qreal x, qreal y);
+
+signals:
+    void handlerChanged();
+    void gainsChanged();
+    void outputChanged();
+
+private:
+    void mix();
+    void sendOutput();
+
+    DeviceHandler *m_handler{};
+
+    int m_frontLeftRight{100};
+    int m_frontUpDown{75};
+    int m_backLeftRight{};
+    int m_backUpDown{100};
+
+    qreal m_x{};
+    qreal m_y{};
+
+    int m_frontLeft{};
+    int m_frontRight{};
+    int m_backLeft{};
+    int m_backRight{};
+};
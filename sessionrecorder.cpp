@@ -0,0 +1,252 @@
+#include "sessionrecorder.h"
+
+// system includes
+#include <algorithm>
+#include <cstring>
+
+// Qt includes
+#include <QtEndian>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+
+namespace {
+constexpr qint64 mappedFileChunkSize = 4 * 1024 * 1024;
+
+// Append-only file that is grown in chunks and written through a memory
+// mapping. close() truncates it back to the bytes actually written.
+class MappedFile
+{
+public:
+    bool open(const QString &fileName, const char *magic, QString &errorString);
+    bool append(const char *data, qint64 size);
+    uchar *reserve(qint64 size);
+    qint64 size() const { return m_used; }
+    void close();
+
+private:
+    QFile m_file;
+    uchar *m_data{};
+    qint64 m_mapped{};
+    qint64 m_used{};
+};
+
+bool MappedFile::open(const QString &fileName, const char *magic, QString &errorString)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        errorString = m_file.errorString();
+        return false;
+    }
+
+    m_used = 0;
+    if (!append(magic, sessionMagicSize))
+    {
+        errorString = m_file.errorString();
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+uchar *MappedFile::reserve(qint64 size)
+{
+    if (m_used + size > m_mapped)
+    {
+        if (m_data)
+        {
+            m_file.unmap(m_data);
+            m_data = nullptr;
+        }
+
+        const qint64 mapped = std::max(m_mapped + mappedFileChunkSize, m_used + size);
+        if (!m_file.resize(mapped))
+            return nullptr;
+
+        m_data = m_file.map(0, mapped);
+        if (!m_data)
+            return nullptr;
+
+        m_mapped = mapped;
+    }
+
+    uchar *ptr = m_data + m_used;
+    m_used += size;
+    return ptr;
+}
+
+bool MappedFile::append(const char *data, qint64 size)
+{
+    uchar *ptr = reserve(size);
+    if (!ptr)
+        return false;
+
+    std::memcpy(ptr, data, size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!m_file.isOpen())
+        return;
+
+    if (m_data)
+    {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+
+    m_file.resize(m_used);
+    m_file.close();
+    m_mapped = 0;
+    m_used = 0;
+}
+}
+
+// Lives in the recorder thread, all methods are invoked queued
+class SessionLogWriter : public QObject
+{
+public:
+    ~SessionLogWriter() override { close(); }
+
+    bool open(const QString &fileName, QString &errorString);
+    bool append(qint64 timestamp, SessionRecordType type, const QByteArray &payload);
+    void close();
+
+private:
+    MappedFile m_log;
+    MappedFile m_index;
+};
+
+bool SessionLogWriter::open(const QString &fileName, QString &errorString)
+{
+    if (!m_log.open(fileName + QStringLiteral(".bblog"), sessionLogMagic, errorString))
+        return false;
+
+    if (!m_index.open(fileName + QStringLiteral(".bbidx"), sessionIndexMagic, errorString))
+    {
+        m_log.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool SessionLogWriter::append(qint64 timestamp, SessionRecordType type, const QByteArray &payload)
+{
+    const quint16 length = quint16(std::min(payload.size(), 0xFFFF));
+    const qint64 offset = m_log.size();
+
+    uchar *record = m_log.reserve(sessionRecordHeaderSize + length);
+    uchar *entry = m_index.reserve(sessionIndexEntrySize);
+    if (!record || !entry)
+        return false;
+
+    qToLittleEndian<qint64>(timestamp, record);
+    record[8] = uchar(type);
+    record[9] = 0;
+    qToLittleEndian<quint16>(length, record + 10);
+    std::memcpy(record + sessionRecordHeaderSize, payload.constData(), length);
+
+    qToLittleEndian<qint64>(timestamp, entry);
+    qToLittleEndian<quint64>(quint64(offset), entry + 8);
+
+    return true;
+}
+
+void SessionLogWriter::close()
+{
+    m_log.close();
+    m_index.close();
+}
+
+SessionRecorder::SessionRecorder(QObject *parent) :
+    QObject{parent},
+    m_writer{new SessionLogWriter}
+{
+    m_clock.start();
+
+    m_thread.setObjectName(QStringLiteral("SessionRecorder"));
+    m_writer->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_thread.start(QThread::LowPriority);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SessionRecorder::start(const QString &fileName)
+{
+    if (m_recording)
+        stop();
+
+    m_fileName = fileName;
+    if (m_fileName.isEmpty())
+    {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir{}.mkpath(dir);
+        m_fileName = dir + QStringLiteral("/session-") + QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss"));
+    }
+
+    // queued before any record() can see m_recording, so the files are open
+    // before the first append arrives
+    QMetaObject::invokeMethod(m_writer, [this, writer = m_writer, fileName = m_fileName]() {
+        QString errorString;
+        if (writer->open(fileName, errorString))
+            return;
+
+        QMetaObject::invokeMethod(this, [this, errorString]() {
+            qWarning() << "could not start recording" << errorString;
+            m_recording = false;
+            emit recordingChanged();
+            emit errorOccurred(errorString);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    m_recordingStart = m_clock.nsecsElapsed() / 1000;
+    m_recording = true;
+    emit recordingChanged();
+}
+
+void SessionRecorder::stop()
+{
+    if (!m_recording)
+        return;
+
+    m_recording = false;
+    emit recordingChanged();
+
+    QMetaObject::invokeMethod(m_writer, [writer = m_writer]() {
+        writer->close();
+    }, Qt::QueuedConnection);
+}
+
+void SessionRecorder::record(SessionRecordType type, const QByteArray &payload)
+{
+    if (!m_recording)
+        return;
+
+    const qint64 timestamp = m_clock.nsecsElapsed() / 1000 - m_recordingStart;
+
+    QMetaObject::invokeMethod(m_writer, [this, writer = m_writer, timestamp, type, payload]() {
+        if (writer->append(timestamp, type, payload))
+            return;
+
+        writer->close();
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_recording)
+                return;
+            qWarning() << "could not write session log";
+            m_recording = false;
+            emit recordingChanged();
+            emit errorOccurred(tr("Could not write session log."));
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// system includes
+#include <atomic>
+#include <cstdint>
+
+// Qt includes
+#include <QObject>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QtQml/qqml.h>
+
+// forward declares
+class SessionLogWriter;
+
+// A session log is made of two append-only files:
+//
+// <name>.bblog: sessionLogMagic followed by one record per frame
+//   i64 timestamp           µs since the recording was started
+//   u8  type                SessionRecordType
+//   u8  reserved
+//   u16 length
+//   u8  payload[length]     the raw frame as received or sent
+//
+// <name>.bbidx: sessionIndexMagic followed by one entry per record
+//   i64 timestamp
+//   u64 offset              of the record in the .bblog file
+//
+// All fields are little endian.
+enum class SessionRecordType : uint8_t
+{
+    Livestats,
+    RemoteControl
+};
+
+constexpr char sessionLogMagic[] = "BBLOG001";
+constexpr char sessionIndexMagic[] = "BBIDX001";
+constexpr int sessionMagicSize = 8;
+constexpr int sessionRecordHeaderSize = 12;
+constexpr int sessionIndexEntrySize = 16;
+
+// Records livestats notifications and control frames to a session log. The
+// files are memory mapped and written from a dedicated thread, record() only
+// hands the (implicitly shared) frame over and never blocks on I/O. record()
+// may be called from any thread, everything else from the owning thread.
+class SessionRecorder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(QString fileName READ fileName NOTIFY recordingChanged)
+    QML_ELEMENT
+    QML_UNCREATABLE("SessionRecorder is owned by DeviceHandler")
+
+public:
+    explicit SessionRecorder(QObject *parent = nullptr);
+    ~SessionRecorder() override;
+
+    bool recording() const { return m_recording; }
+    QString fileName() const { return m_fileName; }
+
+    // without a file name the log is placed in the app data location
+    Q_INVOKABLE void start(const QString &fileName = {});
+    Q_INVOKABLE void stop();
+
+    void record(SessionRecordType type, const QByteArray &payload);
+
+signals:
+    void recordingChanged();
+    void errorOccurred(const QString &message);
+
+private:
+    QThread m_thread;
+    SessionLogWriter *m_writer{};
+    // never restarted, record() reads it from other threads
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_recordingStart{};
+    std::atomic<bool> m_recording{};
+    QString m_fileName;
+};
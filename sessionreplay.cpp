@@ -0,0 +1,266 @@
+#include "sessionreplay.h"
+
+// system includes
+#include <algorithm>
+#include <cstring>
+
+// Qt includes
+#include <QDateTime>
+#include <QtEndian>
+
+// local includes
+#include "devicehandler.h"
+
+namespace {
+// records dispatched per event loop iteration when replaying as fast as
+// possible. DeviceHandler drains the telemetry handoff once per iteration, so
+// this has to stay well below the capacity of DeviceHandoff::telemetry.
+constexpr int maxSpeedBatchSize = 64;
+}
+
+SessionReplay::SessionReplay(QObject *parent) :
+    QObject{parent},
+    m_timer{this}
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &SessionReplay::step);
+}
+
+SessionReplay::~SessionReplay()
+{
+    close();
+}
+
+void SessionReplay::setSpeed(qreal speed)
+{
+    speed = std::max<qreal>(speed, 0.);
+    if (qFuzzyCompare(m_speed, speed))
+        return;
+
+    // keep the current replay position when changing speed mid-play
+    const bool wasPlaying = playing();
+    if (wasPlaying)
+        pause();
+
+    m_speed = speed;
+    emit speedChanged();
+
+    if (wasPlaying)
+        play();
+}
+
+bool SessionReplay::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName + QStringLiteral(".bblog"));
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "could not open session log" << m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_size >= sessionMagicSize ? m_file.map(0, m_size) : nullptr;
+    if (!m_data || std::memcmp(m_data, sessionLogMagic, sessionMagicSize) != 0)
+    {
+        qWarning() << "not a session log" << m_file.fileName();
+        close();
+        return false;
+    }
+
+    if (!loadIndex(fileName))
+        scanLog();
+
+    emit loadedChanged();
+    return true;
+}
+
+void SessionReplay::close()
+{
+    pause();
+
+    const bool wasLoaded = loaded();
+
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    m_file.close();
+    m_offsets.clear();
+
+    if (m_position)
+    {
+        m_position = 0;
+        emit positionChanged();
+    }
+
+    if (wasLoaded)
+        emit loadedChanged();
+}
+
+void SessionReplay::play()
+{
+    if (!loaded() || playing())
+        return;
+
+    if (m_position >= recordCount())
+        seek(0);
+
+    m_clockOffset = recordTimestamp(m_position);
+    m_clock.start();
+    rebaseTime();
+    m_timer.start(0);
+    emit playingChanged();
+}
+
+void SessionReplay::pause()
+{
+    if (!playing())
+        return;
+
+    m_timer.stop();
+    emit playingChanged();
+}
+
+void SessionReplay::seek(int position)
+{
+    position = std::clamp(position, 0, recordCount());
+    if (m_position == position)
+        return;
+
+    m_position = position;
+    emit positionChanged();
+
+    if (playing())
+    {
+        m_clockOffset = recordTimestamp(m_position);
+        m_clock.start();
+        rebaseTime();
+    }
+}
+
+void SessionReplay::rebaseTime()
+{
+    // replayed snapshots keep their recorded spacing, continuing from now
+    // but never before what was already replayed, also after seeking back
+    m_timeBase = std::max(QDateTime::currentMSecsSinceEpoch(), m_lastTimestamp) - m_clockOffset / 1000;
+}
+
+bool SessionReplay::loadIndex(const QString &fileName)
+{
+    QFile index{fileName + QStringLiteral(".bbidx")};
+    if (!index.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = index.size();
+    if (size < sessionMagicSize || (size - sessionMagicSize) % sessionIndexEntrySize)
+        return false;
+
+    const uchar *data = index.map(0, size);
+    if (!data || std::memcmp(data, sessionIndexMagic, sessionMagicSize) != 0)
+        return false;
+
+    const qint64 count = (size - sessionMagicSize) / sessionIndexEntrySize;
+    m_offsets.reserve(count);
+    for (qint64 i = 0; i < count; i++)
+    {
+        const quint64 offset = qFromLittleEndian<quint64>(data + sessionMagicSize + i * sessionIndexEntrySize + 8);
+        if (qint64(offset) + sessionRecordHeaderSize > m_size)
+            break;
+        m_offsets.push_back(offset);
+    }
+
+    index.unmap(const_cast<uchar *>(data));
+    return true;
+}
+
+void SessionReplay::scanLog()
+{
+    // index missing or damaged, walk the records instead
+    qint64 offset = sessionMagicSize;
+    while (offset + sessionRecordHeaderSize <= m_size)
+    {
+        const quint16 length = qFromLittleEndian<quint16>(m_data + offset + 10);
+        if (offset + sessionRecordHeaderSize + length > m_size)
+            break;
+        m_offsets.push_back(quint64(offset));
+        offset += sessionRecordHeaderSize + length;
+    }
+}
+
+qint64 SessionReplay::recordTimestamp(int position) const
+{
+    if (position < 0 || position >= recordCount())
+        return 0;
+
+    return qFromLittleEndian<qint64>(m_data + m_offsets[position]);
+}
+
+void SessionReplay::dispatch(int position)
+{
+    const uchar *record = m_data + m_offsets[position];
+    const auto type = SessionRecordType(record[8]);
+    const quint16 length = qFromLittleEndian<quint16>(record + 10);
+    if (qint64(m_offsets[position]) + sessionRecordHeaderSize + length > m_size)
+        return;
+
+    // points into the mapping, nothing is copied
+    const QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char *>(record + sessionRecordHeaderSize), length);
+
+    switch (type)
+    {
+    case SessionRecordType::Livestats:
+        if (m_handler)
+        {
+            // at max speed the recorded spacing would put the session into
+            // the future, the snapshots are stamped as they come instead
+            const qint64 timestamp = m_speed <= 0. ? QDateTime::currentMSecsSinceEpoch() : m_timeBase + qFromLittleEndian<qint64>(record) / 1000;
+            m_lastTimestamp = std::max(m_lastTimestamp, timestamp);
+            m_handler->injectLivestats(payload, m_lastTimestamp);
+        }
+        break;
+    case SessionRecordType::RemoteControl:
+        emit remoteControlFrame(qFromLittleEndian<qint64>(record), payload);
+        break;
+    }
+}
+
+void SessionReplay::step()
+{
+    const int count = recordCount();
+    const int start = m_position;
+
+    if (m_speed <= 0.)
+    {
+        const int end = std::min(count, m_position + maxSpeedBatchSize);
+        for (; m_position < end; m_position++)
+            dispatch(m_position);
+    }
+    else
+    {
+        const qint64 now = m_clockOffset + qint64(m_clock.nsecsElapsed() / 1000 * m_speed);
+        for (; m_position < count && recordTimestamp(m_position) <= now; m_position++)
+            dispatch(m_position);
+    }
+
+    if (m_position != start)
+        emit positionChanged();
+
+    if (m_position >= count)
+    {
+        emit playingChanged();
+        emit finished();
+        return;
+    }
+
+    if (m_speed <= 0.)
+        m_timer.start(0);
+    else
+    {
+        const qint64 now = m_clockOffset + qint64(m_clock.nsecsElapsed() / 1000 * m_speed);
+        const qint64 wait = qint64((recordTimestamp(m_position) - now) / 1000 / m_speed);
+        m_timer.start(int(std::clamp<qint64>(wait, 0, 1000)));
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+// system includes
+#include <vector>
+
+// Qt includes
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtQml/qqml.h>
+
+// local includes
+#include "sessionrecorder.h"
+
+// forward declares
+class DeviceHandler;
+
+// Plays a session log recorded by SessionRecorder back into a DeviceHandler.
+// Livestats frames go through the regular parsing and property path, control
+// frames are only announced through remoteControlFrame().
+class SessionReplay : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(DeviceHandler* handler READ handler WRITE setHandler NOTIFY handlerChanged)
+    Q_PROPERTY(bool loaded READ loaded NOTIFY loadedChanged)
+    Q_PROPERTY(bool playing READ playing NOTIFY playingChanged)
+    Q_PROPERTY(int recordCount READ recordCount NOTIFY loadedChanged)
+    Q_PROPERTY(int position READ position NOTIFY positionChanged)
+    Q_PROPERTY(qreal speed READ speed WRITE setSpeed NOTIFY speedChanged)
+    QML_ELEMENT
+
+public:
+    explicit SessionReplay(QObject *parent = nullptr);
+    ~SessionReplay() override;
+
+    DeviceHandler* handler() { return m_handler; }
+    const DeviceHandler* handler() const { return m_handler; }
+    void setHandler(DeviceHandler* handler) { if (m_handler == handler) return; m_handler = handler; emit handlerChanged(); }
+
+    bool loaded() const { return m_data != nullptr; }
+    bool playing() const { return m_timer.isActive(); }
+    int recordCount() const { return int(m_offsets.size()); }
+    int position() const { return m_position; }
+
+    // 1 replays in real time, 0 as fast as possible
+    qreal speed() const { return m_speed; }
+    void setSpeed(qreal speed);
+
+    // fileName without the .bblog/.bbidx extension
+    Q_INVOKABLE bool open(const QString &fileName);
+    Q_INVOKABLE void close();
+    Q_INVOKABLE void play();
+    Q_INVOKABLE void pause();
+    Q_INVOKABLE void seek(int position);
+
+signals:
+    void handlerChanged();
+    void loadedChanged();
+    void playingChanged();
+    void positionChanged();
+    void speedChanged();
+    void finished();
+    void remoteControlFrame(qint64 timestamp, const QByteArray &frame);
+
+private:
+    bool loadIndex(const QString &fileName);
+    void scanLog();
+    qint64 recordTimestamp(int position) const;
+    void rebaseTime();
+    void dispatch(int position);
+    void step();
+
+    DeviceHandler *m_handler{};
+
+    QFile m_file;
+    const uchar *m_data{};
+    qint64 m_size{};
+    std::vector<quint64> m_offsets;
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_clockOffset{};
+    // ms since the epoch the recording start is replayed at
+    qint64 m_timeBase{};
+    // of the last replayed snapshot, the history only accepts later ones
+    qint64 m_lastTimestamp{};
+    int m_position{};
+    qreal m_speed{1.};
+};
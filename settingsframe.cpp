@@ -0,0 +1,85 @@
+#include "settingsframe.h"
+
+// Qt includes
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+namespace {
+QByteArray chunkHeader(uint8_t transaction, int index, int count)
+{
+    return QByteArrayLiteral("{\"t\":") + QByteArray::number(transaction) +
+           QByteArrayLiteral(",\"p\":") + QByteArray::number(index) +
+           QByteArrayLiteral(",\"n\":") + QByteArray::number(count) +
+           QByteArrayLiteral(",\"s\":{");
+}
+
+// "key":value exactly as QJsonDocument::Compact writes it
+QByteArray encodeEntry(const QString &key, const QVariant &value)
+{
+    const QByteArray object = QJsonDocument{QJsonObject{{key, QJsonValue::fromVariant(value)}}}.toJson(QJsonDocument::Compact);
+    return object.mid(1, object.size() - 2);
+}
+}
+
+bool encodeSettingsTransaction(const QVariantMap &changes, uint8_t transaction, int maxChunkSize, QVector<QByteArray> &chunks)
+{
+    chunks.clear();
+
+    // sized for the longest possible header, the real ones are never longer
+    constexpr int chunkFooterSize = 2;
+    const int budget = maxChunkSize - chunkHeader(255, 255, 255).size() - chunkFooterSize;
+
+    QVector<QByteArray> bodies;
+    QByteArray body;
+    for (auto iter = changes.cbegin(); iter != changes.cend(); ++iter)
+    {
+        const QByteArray entry = encodeEntry(iter.key(), iter.value());
+        if (entry.size() > budget)
+            return false;
+
+        if (!body.isEmpty() && body.size() + 1 + entry.size() > budget)
+        {
+            bodies.push_back(body);
+            body.clear();
+        }
+
+        if (!body.isEmpty())
+            body += ',';
+        body += entry;
+    }
+    if (!body.isEmpty())
+        bodies.push_back(body);
+
+    if (bodies.size() > 255)
+        return false;
+
+    chunks.reserve(bodies.size());
+    for (int i = 0; i < bodies.size(); ++i)
+        chunks.push_back(chunkHeader(transaction, i, bodies.size()) + bodies.at(i) + QByteArrayLiteral("}}"));
+
+    return true;
+}
+
+bool decodeSettingsChunk(const QByteArray &chunk, SettingsChunk &decoded)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(chunk, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject())
+        return false;
+
+    const QJsonObject obj = doc.object();
+    const QJsonValue transaction = obj.value(QStringLiteral("t"));
+    const QJsonValue index = obj.value(QStringLiteral("p"));
+    const QJsonValue count = obj.value(QStringLiteral("n"));
+    const QJsonValue settings = obj.value(QStringLiteral("s"));
+    if (!transaction.isDouble() || !index.isDouble() || !count.isDouble() || !settings.isObject())
+        return false;
+
+    decoded.transaction = uint8_t(transaction.toInt());
+    decoded.index = index.toInt();
+    decoded.count = count.toInt();
+    decoded.settings = settings.toObject().toVariantMap();
+
+    return decoded.index >= 0 && decoded.index < decoded.count;
+}
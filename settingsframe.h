@@ -0,0 +1,35 @@
+#pragma once
+
+// system includes
+#include <cstdint>
+
+// Qt includes
+#include <QByteArray>
+#include <QVariantMap>
+#include <QVector>
+
+// A settings transaction is written to settingsSetterUuid as one or more
+// JSON chunks, each fitting into a single ATT write:
+//   {"t":7,"p":0,"n":2,"s":{"iDcMax":40,"iMotMax":50}}
+//   t  transaction id, wraps at 256
+//   p  index of this chunk
+//   n  number of chunks in the transaction
+//   s  part of the changed settings, every key appears in exactly one chunk
+//
+// The car applies the settings once all n chunks of a transaction arrived
+// and drops an incomplete transaction when a chunk of another one arrives.
+struct SettingsChunk
+{
+    uint8_t transaction{};
+    int index{};
+    int count{};
+    QVariantMap settings;
+};
+
+// Packs the changes into as few chunks of at most maxChunkSize bytes as
+// possible, keys in sorted order. Fails if a single setting does not fit
+// into a chunk on its own.
+bool encodeSettingsTransaction(const QVariantMap &changes, uint8_t transaction, int maxChunkSize, QVector<QByteArray> &chunks);
+
+// car side of the format
+bool decodeSettingsChunk(const QByteArray &chunk, SettingsChunk &decoded);
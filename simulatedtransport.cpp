@@ -0,0 +1,304 @@
+#include "simulatedtransport.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// km/h per setpoint unit at steady state and how fast the wheels follow
+constexpr float speedPerSetpoint = 0.03f;
+constexpr float speedTimeConstant = 0.5f;
+// A drawn per setpoint unit
+constexpr float currentPerSetpoint = 0.01f;
+constexpr float fullVoltage = 50.4f;
+constexpr float ambientTemperature = 20.f;
+
+float follow(float current, float target, float dt)
+{
+    return current + (target - current) * std::min(dt / speedTimeConstant, 1.f);
+}
+}
+
+SimulatedTransport::SimulatedTransport(QObject *parent) :
+    BobbycarTransport{parent},
+    m_livestatsTimer{this},
+    m_wifiScanTimer{this},
+    m_random{QRandomGenerator::securelySeeded()}
+{
+    m_livestatsTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_livestatsTimer, &QTimer::timeout, this, &SimulatedTransport::sendLivestats);
+    connect(&m_wifiScanTimer, &QTimer::timeout, this, &SimulatedTransport::sendWifiListChunk);
+
+    m_livestats.frontVoltage = fullVoltage;
+    m_livestats.backVoltage = fullVoltage;
+    m_livestats.frontTemperature = ambientTemperature;
+    m_livestats.backTemperature = ambientTemperature;
+}
+
+void SimulatedTransport::setLivestatsRate(int livestatsRate)
+{
+    m_livestatsRate = std::clamp(livestatsRate, 1, 1000);
+    if (m_livestatsTimer.isActive())
+        m_livestatsTimer.start(1000 / m_livestatsRate);
+}
+
+void SimulatedTransport::connectToDevice(const QBluetoothDeviceInfo &device)
+{
+    Q_UNUSED(device)
+
+    m_livestatsTimer.stop();
+    m_remoteControl = {};
+
+    setState(State::Connecting);
+    emit infoMessage(tr("Connecting to simulated bobbycar..."));
+
+    QTimer::singleShot(m_writeLatency, this, [this]() {
+        if (state() != State::Connecting)
+            return;
+        emit infoMessage(tr("Service discovered."));
+        setMtu(m_negotiatedMtu);
+        setState(State::Ready);
+    });
+}
+
+void SimulatedTransport::disconnectFromDevice()
+{
+    m_livestatsTimer.stop();
+    m_wifiScanTimer.stop();
+    m_wifiListNotifications = false;
+    setState(State::Disconnected);
+    setMtu(defaultAttMtu);
+}
+
+bool SimulatedTransport::hasCharacteristic(const QBluetoothUuid &uuid) const
+{
+    return isReady() && (uuid == livestatsCharacUuid || uuid == remotecontrolCharacUuid ||
+                         uuid == settingsSetterUuid || uuid == wifiListUuid);
+}
+
+bool SimulatedTransport::supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const
+{
+    return m_writeWithoutResponseSupported && uuid == remotecontrolCharacUuid && isReady();
+}
+
+void SimulatedTransport::setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled)
+{
+    if (!isReady())
+        return;
+
+    if (uuid == wifiListUuid)
+        m_wifiListNotifications = enabled;
+    else if (uuid != livestatsCharacUuid)
+        return;
+    else if (enabled)
+    {
+        m_clock.start();
+        m_lastUpdate = 0;
+        m_livestatsTimer.start(1000 / m_livestatsRate);
+    }
+    else
+        m_livestatsTimer.stop();
+
+    QTimer::singleShot(m_writeLatency, this, [this, uuid, enabled]() {
+        if (isReady())
+            emit descriptorWritten(uuid, enabled);
+    });
+}
+
+void SimulatedTransport::writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse)
+{
+    if (!hasCharacteristic(uuid))
+    {
+        qWarning() << "unknown characteristic" << uuid;
+        return;
+    }
+
+    const bool lost = m_random.generateDouble() < m_writeLossRate;
+
+    QTimer::singleShot(m_writeLatency, this, [this, uuid, value, withResponse, lost]() {
+        if (!isReady())
+            return;
+
+        if (!lost && uuid == remotecontrolCharacUuid)
+            applyRemoteControl(value);
+        else if (!lost && uuid == settingsSetterUuid)
+            applySettingsChunk(value);
+        else if (!lost && uuid == wifiListUuid)
+            startWifiScan(value);
+
+        if (!withResponse)
+            return;
+
+        QTimer::singleShot(m_acknowledgeLatency, this, [this, uuid, value, lost]() {
+            if (!isReady())
+                return;
+
+            if (lost)
+                emit writeFailed(uuid);
+            else
+                emit characteristicWritten(uuid, value);
+        });
+    });
+}
+
+bool SimulatedTransport::requestConnectionParameters(const QLowEnergyConnectionParameters &parameters)
+{
+    if (!isReady())
+        return false;
+
+    QTimer::singleShot(m_writeLatency, this, [this, parameters]() {
+        if (!isReady())
+            return;
+
+        QLowEnergyConnectionParameters granted = parameters;
+        granted.setIntervalRange(parameters.maximumInterval(), parameters.maximumInterval());
+        emit connectionParametersChanged(granted);
+    });
+
+    return true;
+}
+
+void SimulatedTransport::sendLivestats()
+{
+    const qint64 now = m_clock.elapsed();
+    const float dt = (now - m_lastUpdate) / 1000.f;
+    m_lastUpdate = now;
+
+    m_livestats.frontLeftSpeed = follow(m_livestats.frontLeftSpeed, m_remoteControl.frontLeft * speedPerSetpoint, dt);
+    m_livestats.frontRightSpeed = follow(m_livestats.frontRightSpeed, m_remoteControl.frontRight * speedPerSetpoint, dt);
+    m_livestats.backLeftSpeed = follow(m_livestats.backLeftSpeed, m_remoteControl.backLeft * speedPerSetpoint, dt);
+    m_livestats.backRightSpeed = follow(m_livestats.backRightSpeed, m_remoteControl.backRight * speedPerSetpoint, dt);
+
+    m_livestats.frontLeftDcLink = m_remoteControl.frontLeft * currentPerSetpoint;
+    m_livestats.frontRightDcLink = m_remoteControl.frontRight * currentPerSetpoint;
+    m_livestats.backLeftDcLink = m_remoteControl.backLeft * currentPerSetpoint;
+    m_livestats.backRightDcLink = m_remoteControl.backRight * currentPerSetpoint;
+
+    const float frontCurrent = m_livestats.frontLeftDcLink + m_livestats.frontRightDcLink;
+    const float backCurrent = m_livestats.backLeftDcLink + m_livestats.backRightDcLink;
+
+    // internal resistance sag plus a little noise
+    m_livestats.frontVoltage = fullVoltage - frontCurrent * 0.1f + float(m_random.generateDouble() * 0.05);
+    m_livestats.backVoltage = fullVoltage - backCurrent * 0.1f + float(m_random.generateDouble() * 0.05);
+    m_livestats.frontTemperature = follow(m_livestats.frontTemperature, ambientTemperature + std::abs(frontCurrent) * 2.f, dt / 60.f);
+    m_livestats.backTemperature = follow(m_livestats.backTemperature, ambientTemperature + std::abs(backCurrent) * 2.f, dt / 60.f);
+
+    if (m_livestatsFormat == LivestatsFormat::BinaryV1)
+        encodeLivestatsBinary(m_livestatsBuffer, m_livestats);
+    else
+        encodeLivestatsJson(m_livestatsBuffer, m_livestats);
+
+    if (m_livestatsBuffer.size() > mtu() - attNotificationOverhead)
+        sendFragmented(m_livestatsBuffer);
+    else
+        emit characteristicChanged(livestatsCharacUuid, m_livestatsBuffer);
+}
+
+void SimulatedTransport::sendFragmented(const QByteArray &record)
+{
+    const int payloadSize = mtu() - attNotificationOverhead - livestatsFragmentHeaderSize;
+    const uint8_t sequence = m_fragmentSequence++;
+
+    for (int offset = 0, index = 0; offset < record.size(); offset += payloadSize, index++)
+    {
+        const int size = std::min(payloadSize, record.size() - offset);
+        const bool last = offset + size >= record.size();
+
+        m_fragmentBuffer.resize(0);
+        m_fragmentBuffer.append(char(livestatsFragmentMarker));
+        m_fragmentBuffer.append(char(sequence));
+        m_fragmentBuffer.append(char(index | (last ? livestatsLastFragment : 0)));
+        m_fragmentBuffer.append(record.constData() + offset, size);
+
+        emit characteristicChanged(livestatsCharacUuid, m_fragmentBuffer);
+    }
+}
+
+void SimulatedTransport::applyRemoteControl(const QByteArray &value)
+{
+    RemoteControlSetpoints setpoints;
+    if (!decodeRemoteControl(value, setpoints))
+    {
+        qWarning() << "simulated bobbycar could not decode control frame" << value;
+        return;
+    }
+
+    m_remoteControl = setpoints;
+}
+
+void SimulatedTransport::applySettingsChunk(const QByteArray &value)
+{
+    const uint8_t previousTransaction = m_settingsChunk.transaction;
+    if (!decodeSettingsChunk(value, m_settingsChunk))
+    {
+        qWarning() << "simulated bobbycar could not decode settings chunk" << value;
+        return;
+    }
+
+    // a chunk of another transaction drops the incomplete one
+    if (m_settingsChunksReceived && m_settingsChunk.transaction != previousTransaction)
+    {
+        m_settingsReceived.clear();
+        m_settingsChunksReceived = 0;
+    }
+
+    m_settingsReceived.insert(m_settingsChunk.settings);
+    if (++m_settingsChunksReceived < m_settingsChunk.count)
+        return;
+
+    m_settings.insert(m_settingsReceived);
+    qDebug() << "simulated bobbycar applied settings" << m_settingsReceived;
+
+    m_settingsReceived.clear();
+    m_settingsChunksReceived = 0;
+}
+
+void SimulatedTransport::startWifiScan(const QByteArray &value)
+{
+    if (!parseWifiListRequest(value, m_wifiScan))
+    {
+        qWarning() << "simulated bobbycar could not decode wifi list request" << value;
+        return;
+    }
+
+    if (m_wifiNetworks.isEmpty())
+    {
+        for (int i = 0; i < 40; ++i)
+            m_wifiNetworks.push_back(WifiNetwork{
+                QStringLiteral("simulated-wifi-%0").arg(i),
+                QStringLiteral("02:00:00:00:%0:%1").arg(i / 256, 2, 16, QLatin1Char('0')).arg(i % 256, 2, 16, QLatin1Char('0')),
+                -40 - int(m_random.bounded(50)),
+                i % 5 ? 3 : 0,
+                1 + i % 13
+            });
+    }
+
+    // signal strengths move a bit and a few networks are out of range
+    m_wifiScanResult.clear();
+    for (WifiNetwork &network : m_wifiNetworks)
+    {
+        network.rssi = std::clamp(network.rssi + int(m_random.bounded(7)) - 3, -95, -30);
+        if (m_random.bounded(10))
+            m_wifiScanResult.push_back(network);
+    }
+
+    m_wifiChunkIndex = 0;
+    m_wifiNetworksSent = 0;
+    m_wifiScanTimer.start(100);
+}
+
+void SimulatedTransport::sendWifiListChunk()
+{
+    if (!isReady() || !m_wifiListNotifications)
+    {
+        m_wifiScanTimer.stop();
+        return;
+    }
+
+    m_wifiNetworksSent += encodeWifiListChunk(m_wifiScanResult, m_wifiNetworksSent, m_wifiScan, m_wifiChunkIndex++,
+                                              mtu() - attNotificationOverhead, m_wifiListChunk);
+    emit characteristicChanged(wifiListUuid, m_wifiListChunk);
+
+    if (m_wifiNetworksSent >= m_wifiScanResult.size())
+        m_wifiScanTimer.stop();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// system includes
+#include <algorithm>
+
+// Qt includes
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+// local includes
+#include "bobbycartransport.h"
+#include "livestats.h"
+#include "remotecontrolframe.h"
+#include "settingsframe.h"
+#include "wifilist.h"
+
+// In-process bobbycar: streams livestats at a configurable rate and format
+// and applies control writes after a configurable latency, with optional
+// frame loss. Lets the app be run, tested and benchmarked without a car or a
+// Bluetooth adapter.
+class SimulatedTransport : public BobbycarTransport
+{
+    Q_OBJECT
+
+public:
+    explicit SimulatedTransport(QObject *parent = nullptr);
+
+    bool isSimulated() const override { return true; }
+
+    // notifications per second
+    int livestatsRate() const { return m_livestatsRate; }
+    void setLivestatsRate(int livestatsRate);
+
+    LivestatsFormat livestatsFormat() const { return m_livestatsFormat; }
+    void setLivestatsFormat(LivestatsFormat livestatsFormat) { m_livestatsFormat = livestatsFormat; }
+
+    // milliseconds until a written frame reaches the car
+    int writeLatency() const { return m_writeLatency; }
+    void setWriteLatency(int writeLatency) { m_writeLatency = std::max(0, writeLatency); }
+
+    // additional milliseconds until a write with response is confirmed
+    int acknowledgeLatency() const { return m_acknowledgeLatency; }
+    void setAcknowledgeLatency(int acknowledgeLatency) { m_acknowledgeLatency = std::max(0, acknowledgeLatency); }
+
+    // probability (0..1) that a written frame is lost, lost writes with
+    // response are reported through writeFailed()
+    double writeLossRate() const { return m_writeLossRate; }
+    void setWriteLossRate(double writeLossRate) { m_writeLossRate = std::clamp(writeLossRate, 0., 1.); }
+
+    // MTU the link pretends to negotiate, livestats records that do not fit
+    // into one notification are sent as fragments
+    int negotiatedMtu() const { return m_negotiatedMtu; }
+    void setNegotiatedMtu(int negotiatedMtu) { m_negotiatedMtu = std::max(defaultAttMtu, negotiatedMtu); }
+
+    bool writeWithoutResponseSupported() const { return m_writeWithoutResponseSupported; }
+    void setWriteWithoutResponseSupported(bool supported) { m_writeWithoutResponseSupported = supported; }
+
+    void connectToDevice(const QBluetoothDeviceInfo &device) override;
+    void disconnectFromDevice() override;
+
+    bool hasCharacteristic(const QBluetoothUuid &uuid) const override;
+    bool supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const override;
+
+    void setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled) override;
+
+    void writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse = true) override;
+
+    // grants the longest interval of the requested range after writeLatency
+    bool requestConnectionParameters(const QLowEnergyConnectionParameters &parameters) override;
+
+private:
+    void sendLivestats();
+    void sendFragmented(const QByteArray &record);
+    void applyRemoteControl(const QByteArray &value);
+    void applySettingsChunk(const QByteArray &value);
+    void startWifiScan(const QByteArray &value);
+    void sendWifiListChunk();
+
+    QTimer m_livestatsTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastUpdate{};
+    QRandomGenerator m_random;
+
+    int m_livestatsRate{10};
+    LivestatsFormat m_livestatsFormat{LivestatsFormat::Json};
+    int m_writeLatency{10};
+    int m_acknowledgeLatency{10};
+    double m_writeLossRate{};
+    bool m_writeWithoutResponseSupported{true};
+    int m_negotiatedMtu{185};
+    uint8_t m_fragmentSequence{};
+
+    RemoteControlSetpoints m_remoteControl;
+    Livestats m_livestats;
+    QByteArray m_livestatsBuffer;
+    QByteArray m_fragmentBuffer;
+
+    // settings the simulated car accepted and the transaction being received
+    QVariantMap m_settings;
+    SettingsChunk m_settingsChunk;
+    QVariantMap m_settingsReceived;
+    int m_settingsChunksReceived{};
+
+    // networks around the simulated car, the scan result is streamed in
+    // chunks like a car still scanning would
+    QVector<WifiNetwork> m_wifiNetworks;
+    QVector<WifiNetwork> m_wifiScanResult;
+    QTimer m_wifiScanTimer;
+    bool m_wifiListNotifications{};
+    int m_wifiScan{};
+    int m_wifiChunkIndex{};
+    int m_wifiNetworksSent{};
+    QByteArray m_wifiListChunk;
+};
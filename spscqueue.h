@@ -0,0 +1,81 @@
+#pragma once
+
+// system includes
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. push() and pop() never block and never allocate, push() fails when
+// the consumer has fallen Capacity items behind.
+template<typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+    // producer thread only
+    bool push(const T &value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        m_items[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool pop(T &value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+
+        value = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> m_items{};
+    // kept on separate cache lines, each index is written by one thread only
+    alignas(64) std::atomic<std::size_t> m_head{};
+    alignas(64) std::atomic<std::size_t> m_tail{};
+};
+
+// Lock-free single value handoff (triple buffer) for one producer and one
+// consumer thread. The producer can always publish without waiting, the
+// consumer always takes the newest value and intermediate ones are skipped.
+template<typename T>
+class SpscLatest
+{
+public:
+    // producer thread only
+    void publish(const T &value)
+    {
+        m_buffers[m_back] = value;
+        m_back = m_middle.exchange(m_back | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // consumer thread only, false if nothing was published since the last take
+    bool take(T &value)
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & freshFlag))
+            return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask;
+        value = m_buffers[m_front];
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 0x3;
+    static constexpr int freshFlag = 0x4;
+
+    std::array<T, 3> m_buffers{};
+    int m_back{0};
+    alignas(64) std::atomic<int> m_middle{1};
+    alignas(64) int m_front{2};
+};
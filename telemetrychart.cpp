@@ -0,0 +1,468 @@
+#include "telemetrychart.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+// Qt includes
+#include <QDebug>
+#include <QMatrix4x4>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGNode>
+
+// local includes
+#include "devicehandler.h"
+
+namespace {
+// used for channels without a color
+const QColor defaultColors[] {
+    QColor{0x6c, 0xca, 0xf2},
+    QColor{0xf2, 0x9f, 0x6c},
+    QColor{0x3f, 0xba, 0x62},
+    QColor{0xba, 0x3f, 0x62},
+};
+
+// vertices are relative to m_originTime in floats, the layout is rebuilt
+// before they get too far away from it to stay pixel exact
+constexpr qint64 maxOriginDistance = 1 << 16;
+}
+
+TelemetryChart::TelemetryChart(QQuickItem *parent) :
+    QQuickItem{parent}
+{
+    setFlag(ItemHasContents, true);
+}
+
+void TelemetryChart::setHandler(DeviceHandler* handler)
+{
+    if (m_handler == handler)
+        return;
+
+    if (m_handler)
+        m_handler->disconnect(this);
+
+    m_handler = handler;
+
+    if (m_handler)
+    {
+        connect(m_handler, &DeviceHandler::telemetryChanged, this, &QQuickItem::polish);
+        connect(m_handler, &DeviceHandler::historyCapacityChanged, this, &TelemetryChart::invalidate);
+    }
+
+    invalidate();
+    emit handlerChanged();
+}
+
+void TelemetryChart::setChannels(const QStringList &channels)
+{
+    if (m_channelNames == channels)
+        return;
+
+    m_channelNames = channels;
+    rebuildSeries();
+    emit channelsChanged();
+}
+
+void TelemetryChart::setColors(const QVariantList &colors)
+{
+    if (m_colors == colors)
+        return;
+
+    m_colors = colors;
+    rebuildSeries();
+    emit colorsChanged();
+}
+
+void TelemetryChart::setDuration(int duration)
+{
+    duration = std::max(1000, duration);
+    if (m_duration == duration)
+        return;
+
+    m_duration = duration;
+    invalidate();
+    emit durationChanged();
+}
+
+void TelemetryChart::setAutoRange(bool autoRange)
+{
+    if (m_autoRange == autoRange)
+        return;
+
+    m_autoRange = autoRange;
+    polish();
+    emit autoRangeChanged();
+}
+
+void TelemetryChart::setMinimum(qreal minimum)
+{
+    setAutoRange(false);
+
+    if (m_minimum == minimum)
+        return;
+
+    m_minimum = minimum;
+    update();
+    emit rangeChanged();
+}
+
+void TelemetryChart::setMaximum(qreal maximum)
+{
+    setAutoRange(false);
+
+    if (m_maximum == maximum)
+        return;
+
+    m_maximum = maximum;
+    update();
+    emit rangeChanged();
+}
+
+void TelemetryChart::setLineWidth(qreal lineWidth)
+{
+    if (m_lineWidth == lineWidth)
+        return;
+
+    m_lineWidth = lineWidth;
+    m_nodesDirty = true;
+    update();
+    emit lineWidthChanged();
+}
+
+void TelemetryChart::updatePolish()
+{
+    if (!m_handler || m_series.empty() || width() < 1. || m_handler->history().isEmpty())
+    {
+        m_valid = false;
+        update();
+        return;
+    }
+
+    const TelemetryHistory &history = m_handler->history();
+    const qint64 newestTime = history.lastTimestamp();
+
+    // about one bucket per pixel
+    const int bucketCount = std::max(2, std::min(int(width()), m_duration));
+    const qint64 bucketWidth = std::max<qint64>(1, m_duration / bucketCount);
+    const qint64 newestBucket = newestTime / bucketWidth;
+
+    // a shrinking history or a clock going back means it was cleared
+    const bool incremental = m_valid && bucketWidth == m_bucketWidth &&
+            history.size() >= m_historySize && newestTime >= m_newestTime &&
+            newestBucket - m_newestBucket < m_ringSize &&
+            newestBucket - m_originTime / m_bucketWidth < maxOriginDistance;
+
+    if (incremental)
+    {
+        if (history.size() != m_historySize || newestTime != m_newestTime)
+        {
+            for (Series &series : m_series)
+            {
+                // the last point before the previously newest bucket was
+                // selected against that bucket's mean, which may have moved
+                qint64 from = std::max(m_newestBucket - 1, newestBucket - m_ringSize + 1);
+                while (from > newestBucket - m_ringSize + 1 && !series.points[ringIndex(from)].valid)
+                    from--;
+
+                selectPoints(history, series, from, newestBucket);
+                m_dirtyFrom = std::min(m_dirtyFrom, from);
+            }
+        }
+    }
+    else
+    {
+        m_bucketWidth = bucketWidth;
+        m_bucketCount = int((m_duration + bucketWidth - 1) / bucketWidth);
+        // one more bucket on each side, the leftmost segment starts outside
+        m_ringSize = m_bucketCount + 2;
+        m_originTime = (newestBucket - m_ringSize) * bucketWidth;
+
+        for (Series &series : m_series)
+        {
+            series.points.assign(m_ringSize, {});
+            selectPoints(history, series, newestBucket - m_ringSize + 1, newestBucket);
+        }
+
+        m_valid = true;
+        m_nodesDirty = true;
+    }
+
+    m_historySize = history.size();
+    m_newestTime = newestTime;
+    m_newestBucket = newestBucket;
+
+    updateRange();
+    update();
+}
+
+QSGNode *TelemetryChart::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    if (!m_valid)
+    {
+        delete oldNode;
+        m_nodesDirty = true;
+        m_dirtyFrom = noBucket;
+        return nullptr;
+    }
+
+    auto root = static_cast<QSGTransformNode *>(oldNode);
+    if (!root)
+    {
+        root = new QSGTransformNode;
+        m_nodesDirty = true;
+    }
+
+    qint64 from = m_dirtyFrom;
+    if (m_nodesDirty)
+    {
+        while (QSGNode *child = root->firstChild())
+        {
+            root->removeChildNode(child);
+            delete child;
+        }
+
+        for (const Series &series : m_series)
+        {
+            // one line segment per bucket, in ring order, so a bucket always
+            // keeps its vertices until it scrolls out
+            auto geometry = new QSGGeometry{QSGGeometry::defaultAttributes_Point2D(), 2 * m_ringSize};
+            geometry->setDrawingMode(QSGGeometry::DrawLines);
+            geometry->setVertexDataPattern(QSGGeometry::DynamicPattern);
+            geometry->setLineWidth(float(m_lineWidth));
+
+            auto material = new QSGFlatColorMaterial;
+            material->setColor(series.color);
+
+            auto node = new QSGGeometryNode;
+            node->setGeometry(geometry);
+            node->setMaterial(material);
+            node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+            root->appendChildNode(node);
+        }
+
+        from = m_newestBucket - m_ringSize + 1;
+        m_nodesDirty = false;
+    }
+
+    if (from != noBucket)
+    {
+        from = std::max(from, m_newestBucket - m_ringSize + 1);
+
+        QSGNode *child = root->firstChild();
+        for (const Series &series : m_series)
+        {
+            auto node = static_cast<QSGGeometryNode *>(child);
+            QSGGeometry::Point2D *vertices = node->geometry()->vertexDataAsPoint2D();
+
+            for (qint64 bucket = from; bucket <= m_newestBucket; bucket++)
+            {
+                const int index = ringIndex(bucket);
+                const Point &point = series.points[index];
+                QSGGeometry::Point2D *segment = vertices + 2 * index;
+
+                // segments without length are not drawn
+                if (!point.valid)
+                {
+                    segment[0].set(0.f, 0.f);
+                    segment[1] = segment[0];
+                    continue;
+                }
+
+                segment[1].set(bucketX(point.timestamp), point.value);
+                if (point.connected)
+                    segment[0].set(bucketX(point.fromTimestamp), point.fromValue);
+                else
+                    segment[0] = segment[1];
+            }
+
+            node->markDirty(QSGNode::DirtyGeometry);
+            child = child->nextSibling();
+        }
+
+        m_dirtyFrom = noBucket;
+    }
+
+    // vertices are (bucket since m_originTime, value), scrolling and the
+    // value range only ever change this
+    const double span = m_maximum != m_minimum ? m_maximum - m_minimum : 1.;
+    const double scaleX = width() * m_bucketWidth / m_duration;
+    const double scaleY = height() / span;
+    const double startX = double(m_newestTime - m_duration - m_originTime) / m_bucketWidth;
+
+    QMatrix4x4 matrix;
+    matrix.translate(float(-startX * scaleX), float(height() + m_minimum * scaleY));
+    matrix.scale(float(scaleX), float(-scaleY));
+    root->setMatrix(matrix);
+
+    return root;
+}
+
+void TelemetryChart::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+
+    // the bucket count follows the width, the height only goes into the matrix
+    if (newGeometry.width() != oldGeometry.width())
+        invalidate();
+    else if (newGeometry.height() != oldGeometry.height())
+        update();
+}
+
+void TelemetryChart::invalidate()
+{
+    m_valid = false;
+    polish();
+}
+
+void TelemetryChart::rebuildSeries()
+{
+    m_series.clear();
+
+    for (const QString &name : qAsConst(m_channelNames))
+    {
+        TelemetryHistory::Channel channel;
+        if (!TelemetryHistory::channelFromName(name, channel))
+        {
+            qWarning() << "unknown telemetry channel" << name;
+            continue;
+        }
+
+        const int index = int(m_series.size());
+        QColor color;
+        if (index < m_colors.size())
+            color = m_colors.at(index).value<QColor>();
+        if (!color.isValid())
+            color = defaultColors[index % std::size(defaultColors)];
+
+        m_series.push_back(Series{channel, color, {}});
+    }
+
+    m_nodesDirty = true;
+    invalidate();
+}
+
+void TelemetryChart::selectPoints(const TelemetryHistory &history, Series &series, qint64 from, qint64 to) const
+{
+    // points before from stay as they are, the first one is selected against
+    // the last of them
+    Point previous;
+    for (qint64 bucket = from - 1; bucket > to - m_ringSize; bucket--)
+    {
+        const Point &point = series.points[ringIndex(bucket)];
+        if (point.valid)
+        {
+            previous = point;
+            break;
+        }
+    }
+
+    for (qint64 bucket = from; bucket <= to; bucket++)
+    {
+        Point &point = series.points[ringIndex(bucket)];
+        point = selectPoint(history, series.channel, bucket, previous);
+        if (point.valid)
+            previous = point;
+    }
+}
+
+TelemetryChart::Point TelemetryChart::selectPoint(const TelemetryHistory &history, TelemetryHistory::Channel channel, qint64 bucket, const Point &previous) const
+{
+    const auto [first, last] = history.indexRange(bucket * m_bucketWidth, (bucket + 1) * m_bucketWidth);
+    if (first == last)
+        return {};
+
+    int selected = first;
+    if (last == history.size())
+    {
+        // the newest bucket has no successor, it always shows the newest sample
+        selected = last - 1;
+    }
+    else if (previous.valid)
+    {
+        // largest triangle between the previously selected point, a sample
+        // of this bucket and the mean of the next non empty bucket
+        const qint64 nextBucket = history.timestamp(last) / m_bucketWidth;
+        const int nextLast = history.indexRange(nextBucket * m_bucketWidth, (nextBucket + 1) * m_bucketWidth).second;
+
+        double meanTime{};
+        double meanValue{};
+        for (int i = last; i < nextLast; i++)
+        {
+            meanTime += history.timestamp(i) - previous.timestamp;
+            meanValue += history.value(channel, i) - previous.value;
+        }
+        meanTime /= nextLast - last;
+        meanValue /= nextLast - last;
+
+        double maxArea = -1.;
+        for (int i = first; i < last; i++)
+        {
+            const double time = history.timestamp(i) - previous.timestamp;
+            const double value = history.value(channel, i) - previous.value;
+            const double area = std::abs(meanTime * value - time * meanValue);
+            if (area > maxArea)
+            {
+                maxArea = area;
+                selected = i;
+            }
+        }
+    }
+
+    Point point;
+    point.timestamp = history.timestamp(selected);
+    point.value = history.value(channel, selected);
+    point.valid = true;
+
+    if (previous.valid && point.timestamp - previous.timestamp <= std::max(maxGap, 2 * m_bucketWidth))
+    {
+        point.connected = true;
+        point.fromTimestamp = previous.timestamp;
+        point.fromValue = previous.value;
+    }
+
+    return point;
+}
+
+void TelemetryChart::updateRange()
+{
+    if (!m_autoRange)
+        return;
+
+    float minimum = std::numeric_limits<float>::infinity();
+    float maximum = -std::numeric_limits<float>::infinity();
+
+    const qint64 from = std::max((m_newestTime - m_duration) / m_bucketWidth, m_newestBucket - m_ringSize + 1);
+    for (const Series &series : m_series)
+    {
+        for (qint64 bucket = from; bucket <= m_newestBucket; bucket++)
+        {
+            const Point &point = series.points[ringIndex(bucket)];
+            if (!point.valid)
+                continue;
+
+            minimum = std::min(minimum, point.value);
+            maximum = std::max(maximum, point.value);
+        }
+    }
+
+    if (minimum > maximum)
+        return;
+
+    // a flat line is drawn in the middle
+    if (minimum == maximum)
+    {
+        minimum -= 1.f;
+        maximum += 1.f;
+    }
+
+    if (m_minimum == minimum && m_maximum == maximum)
+        return;
+
+    m_minimum = minimum;
+    m_maximum = maximum;
+    emit rangeChanged();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+// system includes
+#include <limits>
+#include <vector>
+
+// Qt includes
+#include <QColor>
+#include <QQuickItem>
+#include <QStringList>
+#include <QVariantList>
+#include <QtQml/qqml.h>
+
+// local includes
+#include "telemetryhistory.h"
+
+// forward declares
+class DeviceHandler;
+
+// Line chart of TelemetryHistory channels over the last duration ms, rendered
+// straight into the scene graph. Each channel is downsampled to about one
+// point per pixel with largest-triangle-three-buckets, using buckets aligned
+// to absolute time: a new sample only changes the points of the newest few
+// buckets, so only their line segments are rewritten. Scrolling and
+// rescaling only change the transform of the lines.
+class TelemetryChart : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(DeviceHandler* handler READ handler WRITE setHandler NOTIFY handlerChanged)
+    // channel names as in TelemetryHistory::channelName(), e.g. "frontLeftSpeed"
+    Q_PROPERTY(QStringList channels READ channels WRITE setChannels NOTIFY channelsChanged)
+    // one color per channel, missing ones fall back to a default palette
+    Q_PROPERTY(QVariantList colors READ colors WRITE setColors NOTIFY colorsChanged)
+    // ms of history shown, ending at the newest sample
+    Q_PROPERTY(int duration READ duration WRITE setDuration NOTIFY durationChanged)
+    // fits minimum and maximum to the shown values, setting either turns it off
+    Q_PROPERTY(bool autoRange READ autoRange WRITE setAutoRange NOTIFY autoRangeChanged)
+    Q_PROPERTY(qreal minimum READ minimum WRITE setMinimum NOTIFY rangeChanged)
+    Q_PROPERTY(qreal maximum READ maximum WRITE setMaximum NOTIFY rangeChanged)
+    Q_PROPERTY(qreal lineWidth READ lineWidth WRITE setLineWidth NOTIFY lineWidthChanged)
+    QML_ELEMENT
+
+public:
+    // samples further apart than this (or two buckets) are not connected
+    static constexpr qint64 maxGap = 2000;
+
+    explicit TelemetryChart(QQuickItem *parent = nullptr);
+
+    DeviceHandler* handler() { return m_handler; }
+    const DeviceHandler* handler() const { return m_handler; }
+    void setHandler(DeviceHandler* handler);
+
+    QStringList channels() const { return m_channelNames; }
+    void setChannels(const QStringList &channels);
+
+    QVariantList colors() const { return m_colors; }
+    void setColors(const QVariantList &colors);
+
+    int duration() const { return m_duration; }
+    void setDuration(int duration);
+
+    bool autoRange() const { return m_autoRange; }
+    void setAutoRange(bool autoRange);
+
+    qreal minimum() const { return m_minimum; }
+    void setMinimum(qreal minimum);
+    qreal maximum() const { return m_maximum; }
+    void setMaximum(qreal maximum);
+
+    qreal lineWidth() const { return m_lineWidth; }
+    void setLineWidth(qreal lineWidth);
+
+signals:
+    void handlerChanged();
+    void channelsChanged();
+    void colorsChanged();
+    void durationChanged();
+    void autoRangeChanged();
+    void rangeChanged();
+    void lineWidthChanged();
+
+protected:
+    void updatePolish() override;
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    static constexpr qint64 noBucket = std::numeric_limits<qint64>::max();
+
+    // the point LTTB selected for one bucket and the line segment ending there
+    struct Point
+    {
+        qint64 timestamp{};
+        float value{};
+        bool valid{};
+        bool connected{};
+        qint64 fromTimestamp{};
+        float fromValue{};
+    };
+
+    struct Series
+    {
+        TelemetryHistory::Channel channel;
+        QColor color;
+        // indexed by bucket modulo m_ringSize
+        std::vector<Point> points;
+    };
+
+    // starts over with the next polish, e.g. after the layout changed
+    void invalidate();
+    void rebuildSeries();
+
+    void selectPoints(const TelemetryHistory &history, Series &series, qint64 from, qint64 to) const;
+    Point selectPoint(const TelemetryHistory &history, TelemetryHistory::Channel channel, qint64 bucket, const Point &previous) const;
+    void updateRange();
+
+    int ringIndex(qint64 bucket) const
+    {
+        const int index = int(bucket % m_ringSize);
+        return index < 0 ? index + m_ringSize : index;
+    }
+    float bucketX(qint64 timestamp) const { return float(double(timestamp - m_originTime) / m_bucketWidth); }
+
+    DeviceHandler *m_handler{};
+    QStringList m_channelNames;
+    QVariantList m_colors;
+    int m_duration{60000};
+    bool m_autoRange{true};
+    qreal m_minimum{};
+    qreal m_maximum{1.};
+    qreal m_lineWidth{2.};
+
+    std::vector<Series> m_series;
+
+    // bucket layout, fixed until invalidated
+    bool m_valid{};
+    qint64 m_bucketWidth{1};
+    int m_bucketCount{};
+    int m_ringSize{};
+    qint64 m_originTime{};
+
+    // what the last polish saw of the history
+    int m_historySize{};
+    qint64 m_newestTime{};
+    qint64 m_newestBucket{};
+
+    // handed to the render thread, the GUI thread is blocked meanwhile
+    qint64 m_dirtyFrom{noBucket};
+    bool m_nodesDirty{true};
+};
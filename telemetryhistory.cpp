@@ -0,0 +1,207 @@
+#include "telemetryhistory.h"
+
+// system includes
+#include <algorithm>
+#include <limits>
+
+// local includes
+#include "telemetrysnapshot.h"
+
+TelemetryHistory::TelemetryHistory(int capacity)
+{
+    setCapacity(capacity);
+}
+
+void TelemetryHistory::setCapacity(int capacity)
+{
+    m_capacity = std::max(1, capacity);
+    m_head = 0;
+    m_size = 0;
+
+    m_timestamps.assign(m_capacity, 0);
+    m_timestamps.shrink_to_fit();
+    for (auto &channel : m_channels)
+    {
+        channel.assign(m_capacity, 0.f);
+        channel.shrink_to_fit();
+    }
+}
+
+void TelemetryHistory::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+void TelemetryHistory::append(const TelemetrySnapshot &snapshot)
+{
+    append(snapshot.timestamp(), snapshot.livestats());
+}
+
+void TelemetryHistory::append(qint64 timestamp, const Livestats &livestats)
+{
+    // range queries rely on ascending timestamps, a clock stepping back must not break them
+    if (m_size && timestamp < lastTimestamp())
+        timestamp = lastTimestamp();
+
+    int index;
+    if (m_size < m_capacity)
+        index = physicalIndex(m_size++);
+    else
+    {
+        index = m_head;
+        m_head = physicalIndex(1);
+    }
+
+    m_timestamps[index] = timestamp;
+    for (int channel = 0; channel < ChannelCount; channel++)
+        m_channels[channel][index] = channelValue(livestats, Channel(channel));
+}
+
+std::pair<int, int> TelemetryHistory::indexRange(qint64 from, qint64 to) const
+{
+    if (to <= from)
+        return {0, 0};
+
+    return {lowerBound(from), lowerBound(to)};
+}
+
+void TelemetryHistory::downsample(Channel channel, qint64 from, qint64 to, Bucket *buckets, int bucketCount) const
+{
+    if (bucketCount <= 0)
+        return;
+
+    const qint64 span = std::max<qint64>(to - from, 1);
+
+    for (int i = 0; i < bucketCount; i++)
+    {
+        auto &bucket = buckets[i];
+        bucket = {};
+        bucket.begin = from + span * i / bucketCount;
+        bucket.end = from + span * (i + 1) / bucketCount;
+    }
+
+    const auto [first, last] = indexRange(from, to);
+
+    const auto &values = m_channels[channel];
+
+    int bucketIndex = 0;
+    double sum{};
+    for (int i = first; i < last; i++)
+    {
+        const int index = physicalIndex(i);
+        const qint64 timestamp = m_timestamps[index];
+
+        while (timestamp >= buckets[bucketIndex].end && bucketIndex < bucketCount - 1)
+        {
+            if (buckets[bucketIndex].count)
+                buckets[bucketIndex].mean = sum / buckets[bucketIndex].count;
+            sum = 0.;
+            bucketIndex++;
+        }
+
+        auto &bucket = buckets[bucketIndex];
+        const float value = values[index];
+        if (!bucket.count)
+        {
+            bucket.min = value;
+            bucket.max = value;
+        }
+        else
+        {
+            bucket.min = std::min(bucket.min, value);
+            bucket.max = std::max(bucket.max, value);
+        }
+        bucket.count++;
+        sum += value;
+    }
+
+    if (buckets[bucketIndex].count)
+        buckets[bucketIndex].mean = sum / buckets[bucketIndex].count;
+}
+
+float TelemetryHistory::channelValue(const Livestats &livestats, Channel channel)
+{
+    switch (channel)
+    {
+    case FrontVoltage: return livestats.frontVoltage;
+    case BackVoltage: return livestats.backVoltage;
+    case FrontTemperature: return livestats.frontTemperature;
+    case BackTemperature: return livestats.backTemperature;
+    case FrontLeftError: return livestats.frontLeftError;
+    case FrontRightError: return livestats.frontRightError;
+    case BackLeftError: return livestats.backLeftError;
+    case BackRightError: return livestats.backRightError;
+    case FrontLeftSpeed: return livestats.frontLeftSpeed;
+    case FrontRightSpeed: return livestats.frontRightSpeed;
+    case BackLeftSpeed: return livestats.backLeftSpeed;
+    case BackRightSpeed: return livestats.backRightSpeed;
+    case FrontLeftDcLink: return livestats.frontLeftDcLink;
+    case FrontRightDcLink: return livestats.frontRightDcLink;
+    case BackLeftDcLink: return livestats.backLeftDcLink;
+    case BackRightDcLink: return livestats.backRightDcLink;
+    case ChannelCount:
+        break;
+    }
+
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
+const char *TelemetryHistory::channelName(Channel channel)
+{
+    switch (channel)
+    {
+    case FrontVoltage: return "frontVoltage";
+    case BackVoltage: return "backVoltage";
+    case FrontTemperature: return "frontTemperature";
+    case BackTemperature: return "backTemperature";
+    case FrontLeftError: return "frontLeftError";
+    case FrontRightError: return "frontRightError";
+    case BackLeftError: return "backLeftError";
+    case BackRightError: return "backRightError";
+    case FrontLeftSpeed: return "frontLeftSpeed";
+    case FrontRightSpeed: return "frontRightSpeed";
+    case BackLeftSpeed: return "backLeftSpeed";
+    case BackRightSpeed: return "backRightSpeed";
+    case FrontLeftDcLink: return "frontLeftDcLink";
+    case FrontRightDcLink: return "frontRightDcLink";
+    case BackLeftDcLink: return "backLeftDcLink";
+    case BackRightDcLink: return "backRightDcLink";
+    case ChannelCount:
+        break;
+    }
+
+    return "";
+}
+
+bool TelemetryHistory::channelFromName(const QString &name, Channel &channel)
+{
+    for (int i = 0; i < ChannelCount; i++)
+    {
+        if (name == QLatin1String(channelName(Channel(i))))
+        {
+            channel = Channel(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int TelemetryHistory::lowerBound(qint64 timestamp) const
+{
+    int first = 0;
+    int count = m_size;
+    while (count > 0)
+    {
+        const int step = count / 2;
+        if (this->timestamp(first + step) < timestamp)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// system includes
+#include <array>
+#include <utility>
+#include <vector>
+
+// Qt includes
+#include <QString>
+#include <QtGlobal>
+
+// local includes
+#include "livestats.h"
+
+class TelemetrySnapshot;
+
+// Fixed capacity ring buffer of timestamped livestats samples, stored as one
+// contiguous array per channel. All memory is allocated up front (or on
+// setCapacity()), appending never allocates. Once full, the oldest samples
+// are overwritten.
+class TelemetryHistory
+{
+public:
+    enum Channel {
+        FrontVoltage,
+        BackVoltage,
+        FrontTemperature,
+        BackTemperature,
+        FrontLeftError,
+        FrontRightError,
+        BackLeftError,
+        BackRightError,
+        FrontLeftSpeed,
+        FrontRightSpeed,
+        BackLeftSpeed,
+        BackRightSpeed,
+        FrontLeftDcLink,
+        FrontRightDcLink,
+        BackLeftDcLink,
+        BackRightDcLink,
+        ChannelCount
+    };
+
+    struct Bucket
+    {
+        qint64 begin{};
+        qint64 end{};
+        float min{};
+        float max{};
+        float mean{};
+        int count{};
+    };
+
+    // 4 hours at 10 Hz, roughly 10 MiB
+    static constexpr int defaultCapacity = 4 * 60 * 60 * 10;
+
+    explicit TelemetryHistory(int capacity = defaultCapacity);
+
+    int capacity() const { return m_capacity; }
+    // reallocates and therefore drops all samples
+    void setCapacity(int capacity);
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void clear();
+
+    void append(const TelemetrySnapshot &snapshot);
+    void append(qint64 timestamp, const Livestats &livestats);
+
+    // index 0 is the oldest sample still held
+    qint64 timestamp(int index) const { return m_timestamps[physicalIndex(index)]; }
+    float value(Channel channel, int index) const { return m_channels[channel][physicalIndex(index)]; }
+
+    qint64 firstTimestamp() const { return m_size ? timestamp(0) : 0; }
+    qint64 lastTimestamp() const { return m_size ? timestamp(m_size - 1) : 0; }
+
+    // indices [first, last) of the samples with from <= timestamp < to
+    std::pair<int, int> indexRange(qint64 from, qint64 to) const;
+
+    // splits [from, to) into bucketCount equally long windows and fills in
+    // min/max/mean of the channel for each, empty windows get count 0
+    void downsample(Channel channel, qint64 from, qint64 to, Bucket *buckets, int bucketCount) const;
+
+    static float channelValue(const Livestats &livestats, Channel channel);
+    // same names as the DeviceHandler properties, e.g. "frontLeftSpeed"
+    static const char *channelName(Channel channel);
+    // false for unknown names
+    static bool channelFromName(const QString &name, Channel &channel);
+
+private:
+    int physicalIndex(int index) const
+    {
+        const int i = m_head + index;
+        return i >= m_capacity ? i - m_capacity : i;
+    }
+
+    int lowerBound(qint64 timestamp) const;
+
+    int m_capacity{};
+    int m_head{};
+    int m_size{};
+
+    std::vector<qint64> m_timestamps;
+    std::array<std::vector<float>, ChannelCount> m_channels;
+};
@@ -0,0 +1,7 @@
+#include "telemetrysnapshot.h"
+
+TelemetrySnapshot::TelemetrySnapshot(const Livestats &livestats, qint64 timestamp) :
+    m_livestats{livestats},
+    m_timestamp{timestamp}
+{
+}
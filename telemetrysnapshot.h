@@ -0,0 +1,65 @@
+#pragma once
+
+// Qt includes
+#include <QMetaType>
+#include <QtGlobal>
+
+// local includes
+#include "livestats.h"
+
+// Immutable set of all livestats channels received with one notification.
+// Handed to QML as a single value, so bindings reading several channels only
+// re-evaluate once per packet.
+class TelemetrySnapshot
+{
+    Q_GADGET
+    Q_PROPERTY(qint64 timestamp READ timestamp)
+    Q_PROPERTY(float frontVoltage READ frontVoltage)
+    Q_PROPERTY(float backVoltage READ backVoltage)
+    Q_PROPERTY(float frontTemperature READ frontTemperature)
+    Q_PROPERTY(float backTemperature READ backTemperature)
+    Q_PROPERTY(int frontLeftError READ frontLeftError)
+    Q_PROPERTY(int frontRightError READ frontRightError)
+    Q_PROPERTY(int backLeftError READ backLeftError)
+    Q_PROPERTY(int backRightError READ backRightError)
+    Q_PROPERTY(float frontLeftSpeed READ frontLeftSpeed)
+    Q_PROPERTY(float frontRightSpeed READ frontRightSpeed)
+    Q_PROPERTY(float backLeftSpeed READ backLeftSpeed)
+    Q_PROPERTY(float backRightSpeed READ backRightSpeed)
+    Q_PROPERTY(float frontLeftDcLink READ frontLeftDcLink)
+    Q_PROPERTY(float frontRightDcLink READ frontRightDcLink)
+    Q_PROPERTY(float backLeftDcLink READ backLeftDcLink)
+    Q_PROPERTY(float backRightDcLink READ backRightDcLink)
+
+public:
+    TelemetrySnapshot() = default;
+    TelemetrySnapshot(const Livestats &livestats, qint64 timestamp);
+
+    const Livestats &livestats() const { return m_livestats; }
+
+    // milliseconds since epoch the packet was received
+    qint64 timestamp() const { return m_timestamp; }
+
+    float frontVoltage() const { return m_livestats.frontVoltage; }
+    float backVoltage() const { return m_livestats.backVoltage; }
+    float frontTemperature() const { return m_livestats.frontTemperature; }
+    float backTemperature() const { return m_livestats.backTemperature; }
+    int frontLeftError() const { return m_livestats.frontLeftError; }
+    int frontRightError() const { return m_livestats.frontRightError; }
+    int backLeftError() const { return m_livestats.backLeftError; }
+    int backRightError() const { return m_livestats.backRightError; }
+    float frontLeftSpeed() const { return m_livestats.frontLeftSpeed; }
+    float frontRightSpeed() const { return m_livestats.frontRightSpeed; }
+    float backLeftSpeed() const { return m_livestats.backLeftSpeed; }
+    float backRightSpeed() const { return m_livestats.backRightSpeed; }
+    float frontLeftDcLink() const { return m_livestats.frontLeftDcLink; }
+    float frontRightDcLink() const { return m_livestats.frontRightDcLink; }
+    float backLeftDcLink() const { return m_livestats.backLeftDcLink; }
+    float backRightDcLink() const { return m_livestats.backRightDcLink; }
+
+private:
+    Livestats m_livestats;
+    qint64 m_timestamp{};
+};
+
+Q_DECLARE_METATYPE(TelemetrySnapshot)
@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = tst_benchmarks
+
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../bobbycar.pri)
+
+SOURCES += \
+    tst_benchmarks.cpp
+
+# "make benchmark" runs the suite and writes the results twice, as CSV for
+# quick diffs between builds and as XML with the full metadata
+benchmark.commands = $$shell_path($$OUT_PWD/$$TARGET) -o benchmarks.csv,csv -o benchmarks.xml,xml -o -,txt
+benchmark.depends = $(TARGET)
+QMAKE_EXTRA_TARGETS += benchmark
@@ -0,0 +1,443 @@
+// system includes
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Qt includes
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QBluetoothDeviceInfo>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaProperty>
+
+// local includes
+#include "devicefinder.h"
+#include "devicehandler.h"
+#include "livestats.h"
+#include "remotecontrolframe.h"
+
+// Heap allocations of all threads. On glibc malloc itself is interposed, so
+// the QByteArray/QString/QVector allocations Qt does with malloc are counted
+// too, elsewhere only operator new is.
+namespace {
+std::atomic<qint64> allocationCount{};
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+namespace {
+// livestats in the shape the firmware sends them, standing and driving
+const QByteArray jsonStanding = QByteArrayLiteral(
+    "{\"v\":[50.12,50.08],\"t\":[24.5,25.1],\"e\":[0,0,0,0],"
+    "\"s\":[0.00,0.00,0.00,0.00],\"a\":[0.00,0.00,0.00,0.00]}");
+const QByteArray jsonDriving = QByteArrayLiteral(
+    "{\"v\":[47.93,47.88],\"t\":[41.3,43.8],\"e\":[0,0,1,0],"
+    "\"s\":[23.41,23.38,-23.52,-23.47],\"a\":[4.12,4.08,3.97,4.21]}");
+
+// same steps as the DOM based parser the app used before
+bool parseLivestatsDocument(const QByteArray &value, Livestats &livestats)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(value, &error);
+    if (error.error != QJsonParseError::NoError)
+        return false;
+
+    const QJsonObject &obj = doc.object();
+    {
+        const QJsonArray &arr = obj.value("v").toArray();
+        livestats.frontVoltage = arr.at(0).toDouble();
+        livestats.backVoltage = arr.at(1).toDouble();
+    }
+    {
+        const QJsonArray &arr = obj.value("t").toArray();
+        livestats.frontTemperature = arr.at(0).toDouble();
+        livestats.backTemperature = arr.at(1).toDouble();
+    }
+    {
+        const QJsonArray &arr = obj.value("e").toArray();
+        livestats.frontLeftError = arr.at(0).toInt();
+        livestats.frontRightError = arr.at(1).toInt();
+        livestats.backLeftError = arr.at(2).toInt();
+        livestats.backRightError = arr.at(3).toInt();
+    }
+    {
+        const QJsonArray &arr = obj.value("s").toArray();
+        livestats.frontLeftSpeed = arr.at(0).toDouble();
+        livestats.frontRightSpeed = arr.at(1).toDouble();
+        livestats.backLeftSpeed = arr.at(2).toDouble();
+        livestats.backRightSpeed = arr.at(3).toDouble();
+    }
+    {
+        const QJsonArray &arr = obj.value("a").toArray();
+        livestats.frontLeftDcLink = arr.at(0).toDouble();
+        livestats.frontRightDcLink = arr.at(1).toDouble();
+        livestats.backLeftDcLink = arr.at(2).toDouble();
+        livestats.backRightDcLink = arr.at(3).toDouble();
+    }
+    return true;
+}
+
+// Every benchmark has a walltime row and an allocations row, the latter
+// reports heap allocations per operation as QTest::Events, so both end up in
+// the -o file,csv / -o file,xml output.
+void addMetricRows(const char *name)
+{
+    QTest::newRow(QByteArray{name}.append(":walltime").constData()) << false;
+    QTest::newRow(QByteArray{name}.append(":allocations").constData()) << true;
+}
+
+template<typename Functor>
+void measure(bool allocations, Functor &&operation)
+{
+    if (!allocations)
+    {
+        QBENCHMARK {
+            operation();
+        }
+        return;
+    }
+
+    constexpr int iterations = 1000;
+
+    // buffers that are reused grow on the first run
+    operation();
+
+    const qint64 before = allocationCount.load();
+    for (int i = 0; i < iterations; i++)
+        operation();
+    QTest::setBenchmarkResult(qreal(allocationCount.load() - before) / iterations, QTest::Events);
+}
+}
+
+// counts the DeviceHandler notifications the way QML bindings would receive them
+class NotificationCounter : public QObject
+{
+    Q_OBJECT
+
+public:
+    int count{};
+
+public slots:
+    void notified() { count++; }
+};
+
+class tst_Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void livestatsJsonDecode_data();
+    void livestatsJsonDecode();
+    void livestatsJsonDocumentDecode_data();
+    void livestatsJsonDocumentDecode();
+    void livestatsBinaryDecode_data();
+    void livestatsBinaryDecode();
+
+    void controlFrameEncode_data();
+    void controlFrameEncode();
+
+    void deviceHandlerTelemetryFanOut_data();
+    void deviceHandlerTelemetryFanOut();
+
+    void deviceFinderInsert_data();
+    void deviceFinderInsert();
+    void deviceFinderUpdate_data();
+    void deviceFinderUpdate();
+
+private:
+    static std::vector<QBluetoothDeviceInfo> makeDevices(int count, quint64 firstAddress);
+};
+
+void tst_Benchmarks::initTestCase()
+{
+    // keeps DeviceFinder away from the settings of the real app
+    QCoreApplication::setOrganizationName(QStringLiteral("bobbycar-graz-tests"));
+    QCoreApplication::setApplicationName(QStringLiteral("tst_benchmarks"));
+}
+
+void tst_Benchmarks::livestatsJsonDecode_data()
+{
+    QTest::addColumn<QByteArray>("payload");
+    QTest::addColumn<bool>("allocations");
+
+    for (const bool allocations : {false, true})
+    {
+        const char *metric = allocations ? "allocations" : "walltime";
+        QTest::newRow(QByteArray{"standing:"}.append(metric).constData()) << jsonStanding << allocations;
+        QTest::newRow(QByteArray{"driving:"}.append(metric).constData()) << jsonDriving << allocations;
+    }
+}
+
+void tst_Benchmarks::livestatsJsonDecode()
+{
+    QFETCH(QByteArray, payload);
+    QFETCH(bool, allocations);
+
+    Livestats livestats;
+    QString errorString;
+    QVERIFY(parseLivestatsJson(payload, livestats, errorString));
+
+    measure(allocations, [&]() {
+        parseLivestatsJson(payload, livestats, errorString);
+    });
+}
+
+void tst_Benchmarks::livestatsJsonDocumentDecode_data()
+{
+    livestatsJsonDecode_data();
+}
+
+void tst_Benchmarks::livestatsJsonDocumentDecode()
+{
+    QFETCH(QByteArray, payload);
+    QFETCH(bool, allocations);
+
+    Livestats livestats;
+    QVERIFY(parseLivestatsDocument(payload, livestats));
+
+    measure(allocations, [&]() {
+        parseLivestatsDocument(payload, livestats);
+    });
+}
+
+void tst_Benchmarks::livestatsBinaryDecode_data()
+{
+    QTest::addColumn<bool>("allocations");
+    addMetricRows("driving");
+}
+
+void tst_Benchmarks::livestatsBinaryDecode()
+{
+    QFETCH(bool, allocations);
+
+    Livestats driving;
+    QString errorString;
+    QVERIFY(parseLivestatsJson(jsonDriving, driving, errorString));
+
+    QByteArray payload;
+    encodeLivestatsBinary(payload, driving);
+
+    Livestats livestats;
+    QVERIFY(parseLivestatsBinary(payload, livestats, errorString));
+
+    measure(allocations, [&]() {
+        parseLivestatsBinary(payload, livestats, errorString);
+    });
+}
+
+void tst_Benchmarks::controlFrameEncode_data()
+{
+    QTest::addColumn<bool>("binary");
+    QTest::addColumn<bool>("allocations");
+
+    for (const bool allocations : {false, true})
+    {
+        const char *metric = allocations ? "allocations" : "walltime";
+        QTest::newRow(QByteArray{"json:"}.append(metric).constData()) << false << allocations;
+        QTest::newRow(QByteArray{"binary:"}.append(metric).constData()) << true << allocations;
+    }
+}
+
+void tst_Benchmarks::controlFrameEncode()
+{
+    QFETCH(bool, binary);
+    QFETCH(bool, allocations);
+
+    // reused like each of the DeviceWorker::m_remoteControlFrames
+    QByteArray frame;
+    RemoteControlSetpoints setpoints{-512, 487, 1000, -1000};
+    uint8_t sequence{};
+
+    measure(allocations, [&]() {
+        setpoints.frontLeft = -setpoints.frontLeft;
+        if (binary)
+            encodeRemoteControlBinary(frame, sequence++, setpoints);
+        else
+            encodeRemoteControlJson(frame, setpoints);
+    });
+
+    RemoteControlSetpoints decoded;
+    QVERIFY(decodeRemoteControl(frame, decoded));
+    QCOMPARE(decoded.backLeft, setpoints.backLeft);
+}
+
+void tst_Benchmarks::deviceHandlerTelemetryFanOut_data()
+{
+    QTest::addColumn<bool>("allocations");
+    addMetricRows("changing");
+}
+
+void tst_Benchmarks::deviceHandlerTelemetryFanOut()
+{
+    QFETCH(bool, allocations);
+
+    // one livestats frame from injection on the worker thread until every
+    // changed property was announced on this thread
+    DeviceHandler handler;
+
+    NotificationCounter counter;
+    const int notifiedIndex = counter.metaObject()->indexOfSlot("notified()");
+    const QMetaObject *metaObject = handler.metaObject();
+    for (int i = metaObject->propertyOffset(); i < metaObject->propertyCount(); i++)
+    {
+        const QMetaProperty property = metaObject->property(i);
+        if (property.hasNotifySignal())
+            QMetaObject::connect(&handler, property.notifySignalIndex(), &counter, notifiedIndex);
+    }
+
+    int telemetryChanges{};
+    connect(&handler, &DeviceHandler::telemetryChanged, &handler, [&telemetryChanges]() {
+        telemetryChanges++;
+    });
+
+    const QByteArray payloads[] {jsonStanding, jsonDriving};
+    qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    int frame{};
+
+    measure(allocations, [&]() {
+        const int before = telemetryChanges;
+        handler.injectLivestats(payloads[frame++ & 1], timestamp += 100);
+        while (telemetryChanges == before)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    });
+
+    QVERIFY(counter.count > telemetryChanges);
+}
+
+std::vector<QBluetoothDeviceInfo> tst_Benchmarks::makeDevices(int count, quint64 firstAddress)
+{
+    std::vector<QBluetoothDeviceInfo> devices;
+    devices.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        QBluetoothDeviceInfo device{QBluetoothAddress{firstAddress + i}, QStringLiteral("device %0").arg(i), 0};
+        device.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+        device.setRssi(qint16(-40 - i % 50));
+        devices.push_back(device);
+    }
+    return devices;
+}
+
+void tst_Benchmarks::deviceFinderInsert_data()
+{
+    QTest::addColumn<bool>("allocations");
+    addMetricRows("fullList");
+}
+
+void tst_Benchmarks::deviceFinderInsert()
+{
+    QFETCH(bool, allocations);
+
+    // a crowded pit area: the list is full and every new device has to
+    // push out the one unseen for the longest time
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    const std::vector<QBluetoothDeviceInfo> batches[] {
+        makeDevices(DeviceFinder::maxDevices, 0x100000),
+        makeDevices(DeviceFinder::maxDevices, 0x200000)
+    };
+    for (const auto &device : batches[0])
+        emit agent->deviceDiscovered(device);
+
+    int batch{};
+    measure(allocations, [&]() {
+        for (const auto &device : batches[++batch & 1])
+            emit agent->deviceDiscovered(device);
+    });
+
+    QCOMPARE(finder.rowCount({}), DeviceFinder::maxDevices);
+}
+
+void tst_Benchmarks::deviceFinderUpdate_data()
+{
+    QTest::addColumn<bool>("allocations");
+    addMetricRows("fullList");
+}
+
+void tst_Benchmarks::deviceFinderUpdate()
+{
+    QFETCH(bool, allocations);
+
+    // every known device advertising once more with a new RSSI
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    std::vector<QBluetoothDeviceInfo> devices = makeDevices(DeviceFinder::maxDevices, 0x100000);
+    for (const auto &device : devices)
+        emit agent->deviceDiscovered(device);
+
+    qint16 rssi{-40};
+    measure(allocations, [&]() {
+        rssi = rssi == -40 ? -41 : -40;
+        for (auto &device : devices)
+        {
+            device.setRssi(rssi);
+            emit agent->deviceUpdated(device, QBluetoothDeviceInfo::Field::RSSI);
+        }
+    });
+
+    QCOMPARE(finder.rowCount({}), DeviceFinder::maxDevices);
+}
+
+QTEST_GUILESS_MAIN(tst_Benchmarks)
+
+#include "tst_benchmarks.moc"
@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = tst_devicefinder
+
+QT += testlib
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+include(../../bobbycar.pri)
+
+SOURCES += \
+    tst_devicefinder.cpp
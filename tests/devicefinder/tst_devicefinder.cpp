@@ -0,0 +1,163 @@
+// Qt includes
+#include <QtTest>
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QBluetoothDeviceInfo>
+#include <QBluetoothUuid>
+#include <QCoreApplication>
+
+// local includes
+#include "devicefinder.h"
+
+class tst_DeviceFinder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void readvertisingUpdatesInPlace();
+    void silentDeviceRemovedWhenScanFinishes();
+    void listKeptAcrossScans();
+    void hiddenDevicesRemovedWithShowAllDevices();
+    void devicesWithoutAddressCanBeFound();
+
+private:
+    static QBluetoothDeviceInfo makeDevice(quint64 address, const QString &name);
+};
+
+void tst_DeviceFinder::initTestCase()
+{
+    // keeps the known devices and autoConnect of the real app untouched
+    QCoreApplication::setOrganizationName(QStringLiteral("bobbycar-graz-tests"));
+    QCoreApplication::setApplicationName(QStringLiteral("tst_devicefinder"));
+}
+
+QBluetoothDeviceInfo tst_DeviceFinder::makeDevice(quint64 address, const QString &name)
+{
+    QBluetoothDeviceInfo device{QBluetoothAddress{address}, name, 0};
+    device.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    return device;
+}
+
+void tst_DeviceFinder::readvertisingUpdatesInPlace()
+{
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    QBluetoothDeviceInfo device = makeDevice(0x1000, QStringLiteral("bobbycar"));
+    device.setRssi(-70);
+    emit agent->deviceDiscovered(device);
+
+    device.setRssi(-50);
+    emit agent->deviceDiscovered(device);
+
+    QCOMPARE(finder.rowCount({}), 1);
+    QCOMPARE(finder.data(finder.index(0, 0, {}), DeviceFinder::RssiRole).toInt(), -50);
+}
+
+void tst_DeviceFinder::silentDeviceRemovedWhenScanFinishes()
+{
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+    finder.setStaleTimeout(100);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    const QBluetoothDeviceInfo silent = makeDevice(0x1000, QStringLiteral("silent"));
+    QBluetoothDeviceInfo advertising = makeDevice(0x2000, QStringLiteral("advertising"));
+    emit agent->deviceDiscovered(silent);
+    emit agent->deviceDiscovered(advertising);
+    QCOMPARE(finder.rowCount({}), 2);
+
+    QTest::qWait(finder.staleTimeout() + 50);
+
+    advertising.setRssi(-60);
+    emit agent->deviceUpdated(advertising, QBluetoothDeviceInfo::Field::RSSI);
+
+    // the scan may end before the aging timer ever fired
+    emit agent->finished();
+
+    QCOMPARE(finder.rowCount({}), 1);
+    QCOMPARE(finder.data(finder.index(0, 0, {}), DeviceFinder::DeviceIdRole).toString(), DeviceFinder::deviceId(advertising));
+
+    QBluetoothDeviceInfo found;
+    QVERIFY(!finder.findDevice(DeviceFinder::deviceId(silent), found));
+    QVERIFY(finder.findDevice(DeviceFinder::deviceId(advertising), found));
+    QCOMPARE(found.name(), advertising.name());
+}
+
+void tst_DeviceFinder::listKeptAcrossScans()
+{
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    const QBluetoothDeviceInfo device = makeDevice(0x1000, QStringLiteral("bobbycar"));
+    emit agent->deviceDiscovered(device);
+    emit agent->finished();
+
+    // seen recently, so a new scan keeps it instead of starting empty
+    finder.startSearch();
+    agent->stop();
+
+    QCOMPARE(finder.rowCount({}), 1);
+    QCOMPARE(finder.data(finder.index(0, 0, {}), DeviceFinder::DeviceIdRole).toString(), DeviceFinder::deviceId(device));
+}
+
+void tst_DeviceFinder::hiddenDevicesRemovedWithShowAllDevices()
+{
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    emit agent->deviceDiscovered(makeDevice(0x1000, QStringLiteral("bobbycar")));
+    emit agent->deviceDiscovered(makeDevice(0x2000, QStringLiteral("headphones")));
+    QCOMPARE(finder.rowCount({}), 2);
+
+    finder.setShowAllDevices(false);
+
+    QCOMPARE(finder.rowCount({}), 1);
+    QCOMPARE(finder.data(finder.index(0, 0, {}), DeviceFinder::DeviceNameRole).toString(), QStringLiteral("bobbycar"));
+}
+
+void tst_DeviceFinder::devicesWithoutAddressCanBeFound()
+{
+    DeviceFinder finder;
+    finder.setShowAllDevices(true);
+    finder.setAutoConnect(false);
+
+    auto agent = finder.findChild<QBluetoothDeviceDiscoveryAgent *>();
+    QVERIFY(agent);
+
+    // what CoreBluetooth reports, a uuid instead of the address
+    QBluetoothDeviceInfo first{QBluetoothUuid{QStringLiteral("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}")}, QStringLiteral("first"), 0};
+    first.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    QBluetoothDeviceInfo second{QBluetoothUuid{QStringLiteral("{6e400002-b5a3-f393-e0a9-e50e24dcca9e}")}, QStringLiteral("second"), 0};
+    second.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+    emit agent->deviceDiscovered(first);
+    emit agent->deviceDiscovered(second);
+    QCOMPARE(finder.rowCount({}), 2);
+    QVERIFY(DeviceFinder::deviceId(first) != DeviceFinder::deviceId(second));
+
+    QBluetoothDeviceInfo found;
+    QVERIFY(finder.findDevice(DeviceFinder::deviceId(second), found));
+    QCOMPARE(found.name(), second.name());
+}
+
+QTEST_GUILESS_MAIN(tst_DeviceFinder)
+
+#include "tst_devicefinder.moc"
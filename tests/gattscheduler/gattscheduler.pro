@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = tst_gattscheduler
+
+QT += testlib
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+include(../../bobbycar.pri)
+
+SOURCES += \
+    tst_gattscheduler.cpp
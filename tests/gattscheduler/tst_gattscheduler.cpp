@@ -0,0 +1,95 @@
+// Qt includes
+#include <QtTest>
+#include <QSignalSpy>
+
+// local includes
+#include "bobbycartransport.h"
+#include "gattscheduler.h"
+
+// ready right away and records the writes, confirmations are emitted by the test
+class FakeTransport : public BobbycarTransport
+{
+    Q_OBJECT
+
+public:
+    FakeTransport() { setState(State::Ready); }
+
+    void connectToDevice(const QBluetoothDeviceInfo &device) override { Q_UNUSED(device) }
+    void disconnectFromDevice() override {}
+
+    bool hasCharacteristic(const QBluetoothUuid &uuid) const override { Q_UNUSED(uuid) return true; }
+    bool supportsWriteWithoutResponse(const QBluetoothUuid &uuid) const override { Q_UNUSED(uuid) return true; }
+
+    void setNotificationsEnabled(const QBluetoothUuid &uuid, bool enabled) override { Q_UNUSED(uuid) Q_UNUSED(enabled) }
+    void writeCharacteristic(const QBluetoothUuid &uuid, const QByteArray &value, bool withResponse) override
+    {
+        Q_UNUSED(uuid) Q_UNUSED(withResponse)
+        writes.push_back(value);
+    }
+
+    QList<QByteArray> writes;
+};
+
+class tst_GattScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lateConfirmationAfterTimeout();
+    void missingConfirmationIsForgotten();
+};
+
+void tst_GattScheduler::lateConfirmationAfterTimeout()
+{
+    FakeTransport transport;
+    GattScheduler scheduler;
+    scheduler.setTimeout(GattPriority::Control, 50);
+    scheduler.setTransport(&transport);
+
+    QSignalSpy written{&scheduler, &GattScheduler::written};
+    QSignalSpy failed{&scheduler, &GattScheduler::writeFailed};
+
+    scheduler.write(GattPriority::Control, remotecontrolCharacUuid, QByteArrayLiteral("A"));
+    QTRY_COMPARE(failed.count(), 1);
+    QCOMPARE(scheduler.inFlight(), 0);
+
+    scheduler.write(GattPriority::Control, remotecontrolCharacUuid, QByteArrayLiteral("B"));
+    QCOMPARE(transport.writes, (QList<QByteArray>{"A", "B"}));
+
+    // the confirmation of A arrives after all, it must not complete B
+    emit transport.characteristicWritten(remotecontrolCharacUuid, QByteArrayLiteral("A"));
+    QCOMPARE(written.count(), 0);
+    QCOMPARE(scheduler.inFlight(), 1);
+
+    emit transport.characteristicWritten(remotecontrolCharacUuid, QByteArrayLiteral("B"));
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(written.at(0).at(1).toByteArray(), QByteArrayLiteral("B"));
+    QCOMPARE(scheduler.inFlight(), 0);
+    QCOMPARE(failed.count(), 1);
+}
+
+void tst_GattScheduler::missingConfirmationIsForgotten()
+{
+    FakeTransport transport;
+    GattScheduler scheduler;
+    scheduler.setTimeout(GattPriority::Control, 50);
+    scheduler.setTransport(&transport);
+
+    QSignalSpy written{&scheduler, &GattScheduler::written};
+    QSignalSpy failed{&scheduler, &GattScheduler::writeFailed};
+
+    scheduler.write(GattPriority::Control, remotecontrolCharacUuid, QByteArrayLiteral("A"));
+    QTRY_COMPARE(failed.count(), 1);
+
+    // A is never confirmed, after another timeout it stops waiting for it
+    QTest::qWait(scheduler.timeout(GattPriority::Control) + 50);
+
+    scheduler.write(GattPriority::Control, remotecontrolCharacUuid, QByteArrayLiteral("B"));
+    emit transport.characteristicWritten(remotecontrolCharacUuid, QByteArrayLiteral("B"));
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(scheduler.inFlight(), 0);
+}
+
+QTEST_GUILESS_MAIN(tst_GattScheduler)
+
+#include "tst_gattscheduler.moc"
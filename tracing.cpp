@@ -0,0 +1,107 @@
+#include "tracing.h"
+
+// Qt includes
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+Q_LOGGING_CATEGORY(lcBle, "bobbycar.ble", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcGatt, "bobbycar.gatt", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcControl, "bobbycar.control", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcTelemetry, "bobbycar.telemetry", QtInfoMsg)
+
+static_assert((TraceRing::capacity & (TraceRing::capacity - 1)) == 0, "capacity has to be a power of two");
+
+const char *traceEventName(TraceEvent event)
+{
+    switch (event)
+    {
+    case TraceEvent::TransportState: return "TransportState";
+    case TraceEvent::ServiceState: return "ServiceState";
+    case TraceEvent::DescriptorWritten: return "DescriptorWritten";
+    case TraceEvent::GattDispatch: return "GattDispatch";
+    case TraceEvent::GattTimeout: return "GattTimeout";
+    case TraceEvent::ControlWrite: return "ControlWrite";
+    case TraceEvent::ControlAck: return "ControlAck";
+    case TraceEvent::ControlWriteFailed: return "ControlWriteFailed";
+    case TraceEvent::LivestatsReceived: return "LivestatsReceived";
+    case TraceEvent::TelemetryDrained: return "TelemetryDrained";
+    case TraceEvent::EventCount: break;
+    }
+
+    return "Unknown";
+}
+
+TraceRing &TraceRing::instance()
+{
+    static TraceRing ring;
+    return ring;
+}
+
+TraceRing::TraceRing()
+{
+    m_clock.start();
+}
+
+void TraceRing::record(TraceEvent event, qint64 a, qint64 b)
+{
+    const uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[index & (capacity - 1)];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp.store(m_clock.nsecsElapsed() / 1000, std::memory_order_relaxed);
+    slot.thread.store(quint64(quintptr(QThread::currentThreadId())), std::memory_order_relaxed);
+    slot.a.store(a, std::memory_order_relaxed);
+    slot.b.store(b, std::memory_order_relaxed);
+    slot.event.store(uint16_t(event), std::memory_order_relaxed);
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+bool TraceRing::dump(const QString &fileName, QString &errorString) const
+{
+    QFile file{fileName};
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        errorString = file.errorString();
+        return false;
+    }
+
+    QTextStream stream{&file};
+    stream << "# timestamp_us thread event a b\n";
+
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t first = head > uint64_t(capacity) ? head - capacity : 0;
+    for (uint64_t index = first; index < head; ++index)
+    {
+        const Slot &slot = m_slots[index & (capacity - 1)];
+
+        // seqlock read, a record overwritten meanwhile is skipped
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2)
+            continue;
+
+        const qint64 timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        const quint64 thread = slot.thread.load(std::memory_order_relaxed);
+        const qint64 a = slot.a.load(std::memory_order_relaxed);
+        const qint64 b = slot.b.load(std::memory_order_relaxed);
+        const auto event = TraceEvent(slot.event.load(std::memory_order_relaxed));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+        stream << timestamp << ' ' << Qt::hex << thread << Qt::dec << ' ' << traceEventName(event) << ' ' << a << ' ' << b << '\n';
+    }
+
+    stream.flush();
+    if (stream.status() != QTextStream::Ok)
+    {
+        errorString = file.errorString();
+        return false;
+    }
+
+    return true;
+}
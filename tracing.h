@@ -0,0 +1,98 @@
+#pragma once
+
+// system includes
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QString>
+
+// Hot path categories, debug output is off unless enabled through
+// QT_LOGGING_RULES (e.g. "bobbycar.control.debug=true") and compiled out
+// with QT_NO_DEBUG_OUTPUT, which release builds define.
+Q_DECLARE_LOGGING_CATEGORY(lcBle)
+Q_DECLARE_LOGGING_CATEGORY(lcGatt)
+Q_DECLARE_LOGGING_CATEGORY(lcControl)
+Q_DECLARE_LOGGING_CATEGORY(lcTelemetry)
+
+enum class TraceEvent : uint16_t
+{
+    // a = new BobbycarTransport::State, b = previous one
+    TransportState,
+    // a = QLowEnergyService::ServiceState
+    ServiceState,
+    // a = 1 if notifications were enabled, b = descriptor handle
+    DescriptorWritten,
+    // a = priority, b = µs spent queued
+    GattDispatch,
+    // a = priority, b = µs past the deadline
+    GattTimeout,
+    // a = frames sent, b = acknowledged writes in flight
+    ControlWrite,
+    // a = round trip µs, b = writes still in flight
+    ControlAck,
+    // a = writes still in flight, b = frames dropped
+    ControlWriteFailed,
+    // a = bytes, b = µs since the previous notification or -1
+    LivestatsReceived,
+    // a = snapshots drained at once
+    TelemetryDrained,
+    EventCount
+};
+
+const char *traceEventName(TraceEvent event);
+
+// Fixed-size binary trace records in a lock-free ring shared by all threads.
+// Recording is a handful of relaxed stores, no formatting and no allocation,
+// the oldest records are overwritten. Records being written while dump()
+// runs are skipped. Off until enabled.
+class TraceRing
+{
+public:
+    static constexpr int capacity = 8192;
+
+    static TraceRing &instance();
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    void record(TraceEvent event, qint64 a = 0, qint64 b = 0);
+
+    // one line per record, oldest first:
+    //   timestamp_us thread event a b
+    bool dump(const QString &fileName, QString &errorString) const;
+
+private:
+    TraceRing();
+
+    struct Slot
+    {
+        // 2 * index + 1 while being written, 2 * index + 2 once complete
+        std::atomic<uint64_t> sequence{};
+        std::atomic<qint64> timestamp{};
+        std::atomic<quint64> thread{};
+        std::atomic<qint64> a{};
+        std::atomic<qint64> b{};
+        std::atomic<uint16_t> event{};
+    };
+
+    std::atomic<bool> m_enabled{};
+    alignas(64) std::atomic<uint64_t> m_head{};
+    QElapsedTimer m_clock;
+    std::array<Slot, capacity> m_slots;
+};
+
+// Records the event into the TraceRing when enabled and logs it to the
+// category when its debug output is on.
+#define BOBBYCAR_TRACE(category, event, a, b) \
+    do { \
+        const qint64 traceA_ = (a); \
+        const qint64 traceB_ = (b); \
+        TraceRing &traceRing_ = TraceRing::instance(); \
+        if (Q_UNLIKELY(traceRing_.enabled())) \
+            traceRing_.record(event, traceA_, traceB_); \
+        qCDebug(category) << traceEventName(event) << traceA_ << traceB_; \
+    } while (false)
@@ -0,0 +1,109 @@
+#include "wifilist.h"
+
+// Qt includes
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+QByteArray encodeNetwork(const WifiNetwork &network)
+{
+    return QJsonDocument{QJsonObject{
+        {QStringLiteral("n"), network.ssid},
+        {QStringLiteral("b"), network.bssid},
+        {QStringLiteral("r"), network.rssi},
+        {QStringLiteral("e"), network.encryption},
+        {QStringLiteral("c"), network.channel}
+    }}.toJson(QJsonDocument::Compact);
+}
+}
+
+QByteArray encodeWifiListRequest(int scan)
+{
+    return QByteArrayLiteral("{\"s\":") + QByteArray::number(scan) + '}';
+}
+
+bool parseWifiListChunk(const QByteArray &chunk, WifiListChunk &parsed, QString &errorString)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(chunk, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        errorString = error.errorString();
+        return false;
+    }
+    if (!doc.isObject())
+    {
+        errorString = QStringLiteral("not an object");
+        return false;
+    }
+
+    const QJsonObject obj = doc.object();
+    const QJsonValue networks = obj.value(QStringLiteral("w"));
+    if (!obj.value(QStringLiteral("s")).isDouble() || !networks.isArray())
+    {
+        errorString = QStringLiteral("scan id or networks missing");
+        return false;
+    }
+
+    parsed.scan = obj.value(QStringLiteral("s")).toInt();
+    parsed.index = obj.value(QStringLiteral("i")).toInt();
+    parsed.last = obj.value(QStringLiteral("l")).toInt() != 0;
+
+    const QJsonArray array = networks.toArray();
+    parsed.networks.clear();
+    parsed.networks.reserve(array.size());
+    for (const QJsonValue &value : array)
+    {
+        const QJsonObject network = value.toObject();
+        parsed.networks.push_back(WifiNetwork{
+            network.value(QStringLiteral("n")).toString(),
+            network.value(QStringLiteral("b")).toString(),
+            network.value(QStringLiteral("r")).toInt(),
+            network.value(QStringLiteral("e")).toInt(),
+            network.value(QStringLiteral("c")).toInt()
+        });
+    }
+
+    return true;
+}
+
+bool parseWifiListRequest(const QByteArray &request, int &scan)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(request);
+    const QJsonValue value = doc.object().value(QStringLiteral("s"));
+    if (!value.isDouble())
+        return false;
+
+    scan = value.toInt();
+    return true;
+}
+
+int encodeWifiListChunk(const QVector<WifiNetwork> &networks, int first, int scan, int index, int maxSize, QByteArray &chunk)
+{
+    const QByteArray header = QByteArrayLiteral("{\"s\":") + QByteArray::number(scan) +
+                              QByteArrayLiteral(",\"i\":") + QByteArray::number(index) +
+                              QByteArrayLiteral(",\"l\":");
+    // the l digit, ,"w":[ and ]} around the networks
+    constexpr int framingSize = 1 + 6 + 2;
+
+    QByteArray body;
+    int taken{};
+    for (int i = first; i < networks.size(); ++i)
+    {
+        const QByteArray network = encodeNetwork(networks.at(i));
+        // a single network always goes out, even if too long
+        const int size = header.size() + framingSize + body.size() + (taken ? 1 : 0) + network.size();
+        if (size > maxSize && taken)
+            break;
+
+        if (taken)
+            body += ',';
+        body += network;
+        taken++;
+    }
+
+    const bool last = first + taken >= networks.size();
+    chunk = header + (last ? '1' : '0') + QByteArrayLiteral(",\"w\":[") + body + QByteArrayLiteral("]}");
+    return taken;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// system includes
+#include <cstdint>
+
+// Qt includes
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+struct WifiNetwork
+{
+    QString ssid;
+    QString bssid;
+    int rssi{};
+    // wifi_auth_mode_t of the car, 0 is an open network
+    int encryption{};
+    int channel{};
+};
+
+Q_DECLARE_METATYPE(WifiNetwork)
+
+// The app asks for the car's WiFi scan list by writing {"s":3} to
+// wifiListUuid, 3 being a scan id of its choice. The car answers with
+// notifications on the same characteristic, each holding as many networks as
+// fit into one notification:
+//   {"s":3,"i":0,"l":0,"w":[{"n":"ssid","b":"aa:bb:cc:dd:ee:ff","r":-60,"e":3,"c":6},...]}
+//   s  scan id from the request
+//   i  index of this chunk
+//   l  1 on the last chunk of the scan
+//   w  networks: n ssid, b bssid, r rssi in dBm, e encryption, c channel
+// Chunks are sent as soon as results are available, so the first ones arrive
+// long before the scan is done.
+struct WifiListChunk
+{
+    int scan{};
+    int index{};
+    bool last{};
+    QVector<WifiNetwork> networks;
+};
+
+QByteArray encodeWifiListRequest(int scan);
+bool parseWifiListChunk(const QByteArray &chunk, WifiListChunk &parsed, QString &errorString);
+
+// car side of the format
+bool parseWifiListRequest(const QByteArray &request, int &scan);
+// appends networks starting at first until the next
+// one would exceed maxSize, returns how many were taken
+int encodeWifiListChunk(const QVector<WifiNetwork> &networks, int first, int scan, int index, int maxSize, QByteArray &chunk);
@@ -0,0 +1,204 @@
+#include "wifilistmodel.h"
+
+// system includes
+#include <algorithm>
+
+// Qt includes
+#include <QSet>
+
+// local includes
+#include "devicehandler.h"
+
+WifiListModel::WifiListModel(QObject *parent) :
+    QAbstractListModel{parent},
+    m_scanTimer{this}
+{
+    m_scanTimer.setSingleShot(true);
+    connect(&m_scanTimer, &QTimer::timeout, this, [this]() {
+        finishScan(false);
+    });
+}
+
+void WifiListModel::setHandler(DeviceHandler* handler)
+{
+    if (m_handler == handler)
+        return;
+
+    if (m_handler)
+        m_handler->disconnect(this);
+
+    m_handler = handler;
+
+    if (m_handler)
+        connect(m_handler, &DeviceHandler::wifiListReceived, this, &WifiListModel::networksReceived);
+
+    finishScan(false);
+
+    // the networks were seen by the previous car
+    if (!m_networks.empty())
+    {
+        beginResetModel();
+        m_networks.clear();
+        m_rows.clear();
+        endResetModel();
+        emit countChanged();
+    }
+
+    emit handlerChanged();
+}
+
+int WifiListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_networks.size());
+}
+
+QVariant WifiListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= int(m_networks.size()))
+        return {};
+
+    const WifiNetwork &network = m_networks[index.row()].network;
+    switch (role)
+    {
+    case Qt::DisplayRole:
+    case SsidRole: return network.ssid;
+    case BssidRole: return network.bssid;
+    case RssiRole: return network.rssi;
+    case EncryptionRole: return network.encryption;
+    case ChannelRole: return network.channel;
+    }
+
+    return {};
+}
+
+QHash<int, QByteArray> WifiListModel::roleNames() const
+{
+    return {
+        {SsidRole, "ssid"},
+        {BssidRole, "bssid"},
+        {RssiRole, "rssi"},
+        {EncryptionRole, "encryption"},
+        {ChannelRole, "channel"}
+    };
+}
+
+void WifiListModel::refresh()
+{
+    if (!m_handler)
+        return;
+
+    m_scan++;
+    setScanning(true);
+    m_scanTimer.start(scanTimeout);
+
+    m_handler->requestWifiList(m_scan);
+}
+
+void WifiListModel::networksReceived(int scan, const QVector<WifiNetwork> &networks, bool last)
+{
+    if (!m_scanning || scan != m_scan)
+        return;
+
+    // the car may still be scanning, a chunk proves it is alive
+    m_scanTimer.start(scanTimeout);
+
+    QVector<WifiNetwork> added;
+    QSet<QString> addedKeys;
+    for (const WifiNetwork &network : networks)
+    {
+        const QString key = networkKey(network);
+        const auto iter = m_rows.constFind(key);
+        if (iter == m_rows.cend())
+        {
+            // duplicates within one chunk are taken once
+            if (!addedKeys.contains(key))
+            {
+                addedKeys.insert(key);
+                added.push_back(network);
+            }
+            continue;
+        }
+
+        const int row = *iter;
+        Entry &entry = m_networks[row];
+        entry.scan = m_scan;
+
+        QVector<int> roles;
+        if (entry.network.rssi != network.rssi)
+            roles.push_back(RssiRole);
+        if (entry.network.encryption != network.encryption)
+            roles.push_back(EncryptionRole);
+        if (entry.network.channel != network.channel)
+            roles.push_back(ChannelRole);
+
+        if (!roles.isEmpty())
+        {
+            entry.network = network;
+            emit dataChanged(index(row), index(row), roles);
+        }
+    }
+
+    // all networks new in this chunk are inserted in one go
+    const int room = maxNetworks - int(m_networks.size());
+    if (room > 0 && !added.isEmpty())
+    {
+        const int first = int(m_networks.size());
+        const int insert = std::min(room, int(added.size()));
+
+        beginInsertRows({}, first, first + insert - 1);
+        for (int i = 0; i < insert; ++i)
+        {
+            m_rows.insert(networkKey(added.at(i)), int(m_networks.size()));
+            m_networks.push_back(Entry{added.at(i), m_scan});
+        }
+        endInsertRows();
+
+        emit countChanged();
+    }
+
+    if (last)
+        finishScan(true);
+}
+
+void WifiListModel::finishScan(bool complete)
+{
+    m_scanTimer.stop();
+
+    // only a complete scan proves a network is gone
+    if (complete)
+    {
+        const int previousCount = count();
+
+        for (int row = int(m_networks.size()) - 1; row >= 0; row--)
+        {
+            if (m_networks[row].scan == m_scan)
+                continue;
+
+            beginRemoveRows({}, row, row);
+            m_rows.remove(networkKey(m_networks[row].network));
+            m_networks.erase(std::begin(m_networks) + row);
+            for (int i = row; i < int(m_networks.size()); i++)
+                m_rows[networkKey(m_networks[i].network)] = i;
+            endRemoveRows();
+        }
+
+        if (count() != previousCount)
+            emit countChanged();
+    }
+
+    setScanning(false);
+}
+
+void WifiListModel::setScanning(bool scanning)
+{
+    if (m_scanning == scanning)
+        return;
+
+    m_scanning = scanning;
+    emit scanningChanged();
+}
+
+QString WifiListModel::networkKey(const WifiNetwork &network)
+{
+    return network.ssid + QLatin1Char('\n') + network.bssid;
+}
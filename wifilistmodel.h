@@ -0,0 +1,89 @@
+#pragma once
+
+// system includes
+#include <vector>
+
+// Qt includes
+#include <QAbstractListModel>
+#include <QHash>
+#include <QTimer>
+#include <QtQml/qqml.h>
+
+// local includes
+#include "wifilist.h"
+
+// forward declares
+class DeviceHandler;
+
+// WiFi networks the car sees, filled chunk by chunk while the car is still
+// scanning. Networks are identified by SSID and BSSID, a refresh updates
+// known ones in place, appends new ones and drops the ones missing from the
+// completed scan.
+class WifiListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(DeviceHandler* handler READ handler WRITE setHandler NOTIFY handlerChanged)
+    Q_PROPERTY(bool scanning READ scanning NOTIFY scanningChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    QML_ELEMENT
+
+public:
+    enum Roles {
+        SsidRole = Qt::UserRole + 1,
+        BssidRole,
+        RssiRole,
+        EncryptionRole,
+        ChannelRole
+    };
+
+    // a scan without its last chunk for this long counts as finished, the
+    // networks received so far are kept
+    static constexpr int scanTimeout = 15000;
+    static constexpr int maxNetworks = 256;
+
+    explicit WifiListModel(QObject *parent = nullptr);
+
+    DeviceHandler* handler() { return m_handler; }
+    const DeviceHandler* handler() const { return m_handler; }
+    void setHandler(DeviceHandler* handler);
+
+    bool scanning() const { return m_scanning; }
+    int count() const { return int(m_networks.size()); }
+
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // asks the car for a new scan
+    Q_INVOKABLE void refresh();
+
+signals:
+    void handlerChanged();
+    void scanningChanged();
+    void countChanged();
+
+private:
+    //DeviceHandler
+    void networksReceived(int scan, const QVector<WifiNetwork> &networks, bool last);
+
+    void finishScan(bool complete);
+    void setScanning(bool scanning);
+
+    static QString networkKey(const WifiNetwork &network);
+
+    struct Entry
+    {
+        WifiNetwork network;
+        // last scan the network was part of
+        int scan{};
+    };
+
+    DeviceHandler *m_handler{};
+
+    std::vector<Entry> m_networks;
+    QHash<QString, int> m_rows;
+
+    int m_scan{};
+    bool m_scanning{};
+    QTimer m_scanTimer;
+};